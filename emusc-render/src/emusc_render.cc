@@ -0,0 +1,370 @@
+/*
+ *  This file is part of EmuSC, a Sound Canvas emulator
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  EmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with EmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// emusc-render is a command line tool for rendering Standard MIDI Files to
+// WAV files with libEmuSC. Rendering runs as fast as possible, with all MIDI
+// events applied at their exact sample position.
+//
+// Multiple MIDI files can be rendered concurrently (farm mode). All Synth
+// instances share the same read-only control and PCM ROM objects, so memory
+// usage stays almost constant as the number of jobs grows.
+
+
+#include "midi_file.h"
+#include "wav_file.h"
+
+#include "emusc/control_rom.h"
+#include "emusc/pcm_rom.h"
+#include "emusc/synth.h"
+
+#include "config.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+
+struct RenderOptions {
+  std::string controlRom;
+  std::vector<std::string> pcmRoms;
+  std::string output;
+  uint32_t sampleRate = 44100;
+  bool floatFormat = false;
+  EmuSC::Synth::SoundMap soundMap = EmuSC::Synth::SoundMap::GS;
+  unsigned int threads = 1;
+  unsigned int controlPeriod = 16;
+  unsigned int jobs = 1;
+  double tail = 2.0;
+};
+
+
+void show_arguments(std::string program)
+{
+  std::cerr << "Usage: " << program << " [OPTION...] MIDI_FILE...\n\n"
+	    << "Options:\n"
+	    << "  -c, --control-rom FILE  \tControl ROM file (required)\n"
+	    << "  -p, --pcm-rom FILE      \tPCM ROM file, repeat for multiple "
+	    << "files (required)\n"
+	    << "  -o, --output PATH       \tOutput WAV file, or directory if "
+	    << "more than one\n"
+	    << "                          \tMIDI file (default is MIDI file "
+	    << "with .wav suffix)\n"
+	    << "  -r, --sample-rate RATE  \tSample rate in Hz (default 44100)\n"
+	    << "  -f, --float             \tWrite 32 bit float samples "
+	    << "(default 16 bit)\n"
+	    << "  -m, --sound-map MAP     \tSound map: gs, gm or mt32 "
+	    << "(default gs)\n"
+	    << "  -t, --threads N         \tNumber of threads rendering parts "
+	    << "(default 1)\n"
+	    << "  -k, --control-period N  \tFrames between LFO and envelope "
+	    << "updates, 1-64\n"
+	    << "                          \t(default 16)\n"
+	    << "  -j, --jobs N            \tNumber of MIDI files rendered "
+	    << "concurrently\n"
+	    << "                          \t(default 1, 0 = number of CPU "
+	    << "cores)\n"
+	    << "  -T, --tail SECONDS      \tRender time after last MIDI event "
+	    << "(default 2)\n"
+	    << "  -v, --version           \tShow version\n"
+	    << "  -h, --help              \tShow this help message\n"
+	    << std::endl;
+}
+
+
+// Replace MIDI file suffix with .wav. If an output directory is given, the
+// WAV file is placed there instead of next to the MIDI file.
+std::string output_path(std::string midiPath, std::string outputDir = "")
+{
+  std::string::size_type dot = midiPath.find_last_of('.');
+  std::string::size_type slash = midiPath.find_last_of("/\\");
+
+  if (dot != std::string::npos &&
+      (slash == std::string::npos || dot > slash))
+    midiPath.erase(dot);
+
+  if (!outputDir.empty()) {
+    if (slash != std::string::npos)
+      midiPath.erase(0, slash + 1);
+    if (outputDir.back() != '/' && outputDir.back() != '\\')
+      outputDir.append("/");
+    midiPath = outputDir + midiPath;
+  }
+
+  return midiPath + ".wav";
+}
+
+
+// Output frame of a MIDI event
+uint64_t event_frame(const MidiFile::Event &event, uint32_t sampleRate)
+{
+  return (uint64_t) (event.time * sampleRate + 0.5);
+}
+
+
+// Render one MIDI file to WAV. Returns number of seconds of audio rendered.
+double render_file(const EmuSC::ControlRom &ctrlRom,
+		   const EmuSC::PcmRom &pcmRom,
+		   const RenderOptions &options, std::string midiPath,
+		   std::string wavPath)
+{
+  // Keep number of events waiting in the MIDI event queue of libEmuSC well
+  // below its size
+  const size_t maxQueuedEvents = 512;
+  const uint32_t chunkFrames = 4096;
+
+  MidiFile midiFile(midiPath);
+  WavFile wavFile(wavPath, options.sampleRate, 2, options.floatFormat);
+
+  EmuSC::Synth synth(ctrlRom, pcmRom, options.soundMap);
+  synth.set_audio_format(options.sampleRate, 2);
+  synth.set_render_threads(options.threads);
+  synth.set_control_period(options.controlPeriod);
+
+  // When resampling, the engine renders ahead of the output. Events are
+  // queued this many frames ahead of the chunk so they are never late.
+  const uint32_t lookahead = synth.render_lookahead();
+
+  const std::vector<MidiFile::Event> &events = midiFile.events();
+  uint64_t totalFrames =
+    (uint64_t) ((midiFile.length() + options.tail) * options.sampleRate);
+
+  std::vector<int16_t> intBuffer(chunkFrames * 2);
+  std::vector<float> floatBuffer(chunkFrames * 2);
+
+  size_t ei = 0;                 // Next event to queue
+  size_t ci = 0;                 // First event not yet rendered
+  uint64_t pos = 0;
+  while (pos < totalFrames) {
+    uint64_t end = pos + chunkFrames;
+    if (end > totalFrames)
+      end = totalFrames;
+
+    // Events before the chunk have been consumed by the synth
+    while (ci < ei && event_frame(events[ci], options.sampleRate) < pos)
+      ci++;
+
+    // Queue all events inside this chunk and the engine lookahead with their
+    // exact frame position
+    while (ei < events.size()) {
+      uint64_t frame = event_frame(events[ei], options.sampleRate);
+      if (frame >= end + lookahead)
+	break;
+
+      if (ei - ci == maxQueuedEvents) {
+	end = (frame > pos + lookahead) ? frame - lookahead : pos + 1;
+	break;
+      }
+
+      const std::vector<uint8_t> &data = events[ei].data;
+      if (data[0] == 0xf0)
+	synth.midi_input_sysex((uint8_t *) data.data(), data.size(), frame);
+      else
+	synth.midi_input(data[0], data[1], data.size() > 2 ? data[2] : 0,
+			 frame);
+
+      ei++;
+    }
+
+    uint32_t frames = end - pos;
+    if (options.floatFormat) {
+      synth.render(floatBuffer.data(), frames);
+      wavFile.write(floatBuffer.data(), frames);
+    } else {
+      synth.render(intBuffer.data(), frames);
+      wavFile.write(intBuffer.data(), frames);
+    }
+
+    pos = end;
+  }
+
+  wavFile.close();
+
+  return (double) totalFrames / options.sampleRate;
+}
+
+
+int parse_arguments(int argc, char *argv[], RenderOptions &options,
+		    std::vector<std::string> &midiFiles)
+{
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "-h" || arg == "--help") {
+      show_arguments(argv[0]);
+      return 1;
+    } else if (arg == "-v" || arg == "--version") {
+      std::cout << "emusc-render " << VERSION << " (libEmuSC "
+		<< EmuSC::Synth::version() << ")" << std::endl;
+      return 1;
+    } else if (arg == "-f" || arg == "--float") {
+      options.floatFormat = true;
+    } else if ((arg == "-c" || arg == "--control-rom") && hasValue) {
+      options.controlRom = argv[++i];
+    } else if ((arg == "-p" || arg == "--pcm-rom") && hasValue) {
+      options.pcmRoms.push_back(argv[++i]);
+    } else if ((arg == "-o" || arg == "--output") && hasValue) {
+      options.output = argv[++i];
+    } else if ((arg == "-r" || arg == "--sample-rate") && hasValue) {
+      options.sampleRate = atoi(argv[++i]);
+    } else if ((arg == "-t" || arg == "--threads") && hasValue) {
+      options.threads = atoi(argv[++i]);
+    } else if ((arg == "-k" || arg == "--control-period") && hasValue) {
+      options.controlPeriod = atoi(argv[++i]);
+    } else if ((arg == "-j" || arg == "--jobs") && hasValue) {
+      options.jobs = atoi(argv[++i]);
+    } else if ((arg == "-T" || arg == "--tail") && hasValue) {
+      options.tail = atof(argv[++i]);
+    } else if ((arg == "-m" || arg == "--sound-map") && hasValue) {
+      std::string map = argv[++i];
+      if (map == "gs") {
+	options.soundMap = EmuSC::Synth::SoundMap::GS;
+      } else if (map == "gm") {
+	options.soundMap = EmuSC::Synth::SoundMap::GS_GM;
+      } else if (map == "mt32") {
+	options.soundMap = EmuSC::Synth::SoundMap::MT32;
+      } else {
+	std::cerr << "EmuSC: Unknown sound map " << map << std::endl;
+	return -1;
+      }
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      std::cerr << "EmuSC: Unknown or incomplete option " << arg << std::endl;
+      show_arguments(argv[0]);
+      return -1;
+    } else {
+      midiFiles.push_back(arg);
+    }
+  }
+
+  if (options.controlRom.empty() || options.pcmRoms.empty() ||
+      midiFiles.empty()) {
+    show_arguments(argv[0]);
+    return -1;
+  }
+
+  if (options.sampleRate < 8000 || options.sampleRate > 192000) {
+    std::cerr << "EmuSC: Unsupported sample rate " << options.sampleRate
+	      << std::endl;
+    return -1;
+  }
+
+  if (options.jobs == 0)
+    options.jobs = std::thread::hardware_concurrency();
+  if (options.jobs == 0)
+    options.jobs = 1;
+  if (options.jobs > midiFiles.size())
+    options.jobs = midiFiles.size();
+
+  return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+  RenderOptions options;
+  std::vector<std::string> midiFiles;
+
+  int ret = parse_arguments(argc, argv, options, midiFiles);
+  if (ret)
+    return ret < 0 ? 1 : 0;
+
+  EmuSC::ControlRom *ctrlRom = NULL;
+  EmuSC::PcmRom *pcmRom = NULL;
+
+  try {
+    ctrlRom = new EmuSC::ControlRom(options.controlRom);
+    pcmRom = new EmuSC::PcmRom(options.pcmRoms, *ctrlRom);
+  } catch (std::string errorMsg) {
+    std::cerr << "EmuSC: Failed to load ROM files: " << errorMsg << std::endl;
+    delete pcmRom;
+    delete ctrlRom;
+    return 1;
+  }
+
+  // Render files on a number of worker threads, all sharing the same ROMs
+  std::atomic<size_t> nextFile(0);
+  std::atomic<int> failed(0);
+  std::mutex outputMutex;
+  double totalAudioTime = 0;
+
+  auto worker = [&]() {
+    size_t i;
+    while ((i = nextFile.fetch_add(1)) < midiFiles.size()) {
+      std::string midiPath = midiFiles[i];
+      std::string wavPath;
+      if (midiFiles.size() == 1 && !options.output.empty())
+	wavPath = options.output;
+      else
+	wavPath = output_path(midiPath, options.output);
+
+      try {
+	auto start = std::chrono::steady_clock::now();
+	double audioTime = render_file(*ctrlRom, *pcmRom, options, midiPath,
+				       wavPath);
+	std::chrono::duration<double> renderTime =
+	  std::chrono::steady_clock::now() - start;
+
+	std::lock_guard<std::mutex> lock(outputMutex);
+	totalAudioTime += audioTime;
+	std::cout << "EmuSC: Rendered " << midiPath << " -> " << wavPath
+		  << std::endl << " -> " << audioTime << " s audio in "
+		  << renderTime.count() << " s ("
+		  << audioTime / renderTime.count() << "x realtime)"
+		  << std::endl;
+
+      } catch (std::string errorMsg) {
+	std::lock_guard<std::mutex> lock(outputMutex);
+	std::cerr << "EmuSC: " << errorMsg << std::endl;
+	failed++;
+      }
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < options.jobs; i++)
+    workers.emplace_back(worker);
+  worker();
+  for (auto &t : workers)
+    t.join();
+
+  std::chrono::duration<double> totalTime =
+    std::chrono::steady_clock::now() - start;
+
+  if (midiFiles.size() > 1)
+    std::cout << "EmuSC: Rendered " << midiFiles.size() - failed << " of "
+	      << midiFiles.size() << " files with " << options.jobs
+	      << " jobs" << std::endl << " -> " << totalAudioTime
+	      << " s audio in " << totalTime.count() << " s ("
+	      << totalAudioTime / totalTime.count() << "x realtime)"
+	      << std::endl;
+
+  ret = failed ? 1 : 0;
+
+  delete pcmRom;
+  delete ctrlRom;
+
+  return ret;
+}
@@ -0,0 +1,200 @@
+/*
+ *  This file is part of EmuSC, a Sound Canvas emulator
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  EmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with EmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "midi_file.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+
+MidiFile::MidiFile(std::string filePath)
+{
+  std::ifstream file(filePath, std::ios::binary | std::ios::in);
+  if (!file.is_open())
+    throw(std::string("Unable to open MIDI file ") + filePath);
+
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+			    std::istreambuf_iterator<char>());
+
+  if (data.size() < 14 || std::string(data.begin(), data.begin() + 4) != "MThd")
+    throw(std::string("Not a Standard MIDI File: ") + filePath);
+
+  uint32_t headerLength = data[4] << 24 | data[5] << 16 | data[6] << 8 | data[7];
+  uint16_t format = data[8] << 8 | data[9];
+  uint16_t numTracks = data[10] << 8 | data[11];
+  uint16_t division = data[12] << 8 | data[13];
+
+  if (format > 1)
+    throw(std::string("Unsupported MIDI file format ") +
+	  std::to_string(format) + ": " + filePath);
+  if (division == 0)
+    throw(std::string("Invalid time division in MIDI file ") + filePath);
+
+  // Read all track chunks. Unknown chunk types are skipped.
+  std::vector<TrackEvent> trackEvents;
+  uint32_t pos = 8 + headerLength;
+  uint16_t track = 0;
+  while (pos + 8 <= data.size() && track < numTracks) {
+    uint32_t chunkLength = data[pos + 4] << 24 | data[pos + 5] << 16 |
+                           data[pos + 6] << 8  | data[pos + 7];
+    uint32_t chunkStart = pos + 8;
+    if (chunkLength > data.size() - chunkStart)
+      chunkLength = data.size() - chunkStart;         // Truncated file
+
+    if (std::string(data.begin() + pos, data.begin() + pos + 4) == "MTrk")
+      _read_track(&data[chunkStart], chunkLength, track++, trackEvents);
+
+    pos = chunkStart + chunkLength;
+  }
+
+  std::sort(trackEvents.begin(), trackEvents.end(),
+	    [](const TrackEvent &a, const TrackEvent &b) {
+	      if (a.tick != b.tick) return a.tick < b.tick;
+	      if (a.track != b.track) return a.track < b.track;
+	      return a.order < b.order; });
+
+  // Convert ticks to seconds. Default tempo is 120 BPM.
+  double secondsPerTick;
+  bool smpte = division & 0x8000;
+  if (smpte) {
+    int fps = -((int8_t) (division >> 8));
+    secondsPerTick = 1.0 / ((fps == 29 ? 29.97 : fps) * (division & 0xff));
+  } else {
+    secondsPerTick = 0.5 / division;
+  }
+
+  double time = 0;
+  uint32_t lastTick = 0;
+  for (auto &e : trackEvents) {
+    time += (e.tick - lastTick) * secondsPerTick;
+    lastTick = e.tick;
+
+    // Set Tempo meta event: ff 51 03 tt tt tt
+    if (e.data[0] == 0xff) {
+      if (e.data.size() == 6 && e.data[1] == 0x51 && !smpte) {
+	uint32_t usPerBeat = e.data[3] << 16 | e.data[4] << 8 | e.data[5];
+	secondsPerTick = usPerBeat / 1000000.0 / division;
+      }
+      continue;
+    }
+
+    _events.push_back({ time, std::move(e.data) });
+  }
+}
+
+
+MidiFile::~MidiFile()
+{}
+
+
+double MidiFile::length(void)
+{
+  if (_events.empty())
+    return 0;
+
+  return _events.back().time;
+}
+
+
+void MidiFile::_read_track(const uint8_t *data, uint32_t length,
+			   uint16_t track, std::vector<TrackEvent> &trackEvents)
+{
+  uint32_t pos = 0;
+  uint32_t tick = 0;
+  uint32_t order = 0;
+  uint8_t runningStatus = 0;
+
+  while (pos < length) {
+    tick += _read_varlen(data, length, pos);
+    if (pos >= length)
+      break;
+
+    uint8_t status = data[pos];
+    if (status < 0x80) {                                    // Running status
+      if (!runningStatus)
+	return;                                             // Corrupt track
+      status = runningStatus;
+    } else {
+      pos++;
+    }
+
+    std::vector<uint8_t> event;
+
+    if (status == 0xff) {                                   // Meta event
+      if (pos >= length)
+	return;
+      uint8_t type = data[pos++];
+      uint32_t len = _read_varlen(data, length, pos);
+      if (type == 0x2f)                                     // End of track
+	return;
+      if (len > length - pos)
+	return;
+
+      event.push_back(0xff);
+      event.push_back(type);
+      event.push_back(len);
+      event.insert(event.end(), data + pos, data + pos + len);
+      pos += len;
+
+    } else if (status == 0xf0 || status == 0xf7) {          // SysEx
+      uint32_t len = _read_varlen(data, length, pos);
+      if (len > length - pos)
+	return;
+
+      // Escaped (0xf7) SysEx packets are not supported
+      if (status == 0xf0) {
+	event.push_back(0xf0);
+	event.insert(event.end(), data + pos, data + pos + len);
+      }
+      pos += len;
+      runningStatus = 0;
+
+    } else {                                                // Channel message
+      int dataBytes = ((status & 0xf0) == 0xc0 ||
+		       (status & 0xf0) == 0xd0) ? 1 : 2;
+      if (pos + dataBytes > length)
+	return;
+
+      event.push_back(status);
+      for (int i = 0; i < dataBytes; i++)
+	event.push_back(data[pos++]);
+      runningStatus = status;
+    }
+
+    if (!event.empty())
+      trackEvents.push_back({ tick, track, order++, std::move(event) });
+  }
+}
+
+
+uint32_t MidiFile::_read_varlen(const uint8_t *data, uint32_t length,
+				uint32_t &pos)
+{
+  uint32_t value = 0;
+
+  for (int i = 0; i < 4 && pos < length; i++) {
+    uint8_t byte = data[pos++];
+    value = (value << 7) | (byte & 0x7f);
+    if (!(byte & 0x80))
+      break;
+  }
+
+  return value;
+}
@@ -0,0 +1,67 @@
+/*
+ *  This file is part of EmuSC, a Sound Canvas emulator
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  EmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with EmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Standard MIDI File (SMF) reader. Supports format 0 and 1 files with both
+// metrical (PPQN) and SMPTE time division. All tracks are merged into one
+// list of events sorted by time, with tempo changes applied.
+
+
+#ifndef MIDI_FILE_H
+#define MIDI_FILE_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+
+class MidiFile
+{
+public:
+  struct Event {
+    double time;                  // Seconds from start of file
+    std::vector<uint8_t> data;    // Raw MIDI message, SysEx includes 0xf0
+  };
+
+  MidiFile(std::string filePath);
+  ~MidiFile();
+
+  const std::vector<Event> &events(void) { return _events; }
+
+  // Time of last event in seconds
+  double length(void);
+
+private:
+  struct TrackEvent {
+    uint32_t tick;
+    uint16_t track;
+    uint32_t order;               // Position in track, keeps sort stable
+    std::vector<uint8_t> data;    // Meta events start with 0xff
+  };
+
+  std::vector<Event> _events;
+
+  void _read_track(const uint8_t *data, uint32_t length, uint16_t track,
+		   std::vector<TrackEvent> &trackEvents);
+  uint32_t _read_varlen(const uint8_t *data, uint32_t length, uint32_t &pos);
+
+  MidiFile();
+};
+
+
+#endif  // MIDI_FILE_H
@@ -0,0 +1,96 @@
+/*
+ *  This file is part of EmuSC, a Sound Canvas emulator
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  EmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with EmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "wav_file.h"
+
+
+WavFile::WavFile(std::string filePath, uint32_t sampleRate, uint8_t channels,
+		 bool floatFormat)
+  : _channels(channels),
+    _bytesPerSample(floatFormat ? 4 : 2),
+    _dataSize(0)
+{
+  _file.open(filePath, std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!_file.is_open())
+    throw(std::string("Unable to open output file ") + filePath);
+
+  // Header with RIFF and data sizes set to 0 until file is closed
+  _file.write("RIFF", 4);
+  _write_uint32(0);
+  _file.write("WAVEfmt ", 8);
+  _write_uint32(16);
+  _write_uint16(floatFormat ? 3 : 1);                 // 3 = IEEE float
+  _write_uint16(channels);
+  _write_uint32(sampleRate);
+  _write_uint32(sampleRate * channels * _bytesPerSample);
+  _write_uint16(channels * _bytesPerSample);
+  _write_uint16(_bytesPerSample * 8);
+  _file.write("data", 4);
+  _write_uint32(0);
+}
+
+
+WavFile::~WavFile()
+{
+  close();
+}
+
+
+// Samples are written in host byte order, WAV files are little endian
+void WavFile::write(const int16_t *samples, uint32_t frames)
+{
+  _file.write((const char *) samples, frames * _channels * sizeof(int16_t));
+  _dataSize += frames * _channels * sizeof(int16_t);
+}
+
+
+void WavFile::write(const float *samples, uint32_t frames)
+{
+  _file.write((const char *) samples, frames * _channels * sizeof(float));
+  _dataSize += frames * _channels * sizeof(float);
+}
+
+
+void WavFile::close(void)
+{
+  if (!_file.is_open())
+    return;
+
+  _file.seekp(4);
+  _write_uint32(_dataSize + 36);
+  _file.seekp(40);
+  _write_uint32(_dataSize);
+
+  _file.close();
+}
+
+
+void WavFile::_write_uint16(uint16_t value)
+{
+  char b[2] = { (char) (value & 0xff), (char) (value >> 8) };
+  _file.write(b, 2);
+}
+
+
+void WavFile::_write_uint32(uint32_t value)
+{
+  char b[4] = { (char) (value & 0xff), (char) ((value >> 8) & 0xff),
+		(char) ((value >> 16) & 0xff), (char) (value >> 24) };
+  _file.write(b, 4);
+}
@@ -0,0 +1,58 @@
+/*
+ *  This file is part of EmuSC, a Sound Canvas emulator
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  EmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  EmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with EmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Minimal WAV file writer for 16 bit PCM or 32 bit float stereo audio. Data
+// sizes in the header are updated when the file is closed.
+
+
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include <stdint.h>
+
+#include <fstream>
+#include <string>
+
+
+class WavFile
+{
+public:
+  WavFile(std::string filePath, uint32_t sampleRate, uint8_t channels,
+	  bool floatFormat);
+  ~WavFile();
+
+  void write(const int16_t *samples, uint32_t frames);
+  void write(const float *samples, uint32_t frames);
+
+  void close(void);
+
+private:
+  std::ofstream _file;
+
+  uint8_t _channels;
+  uint8_t _bytesPerSample;
+  uint32_t _dataSize;
+
+  void _write_uint16(uint16_t value);
+  void _write_uint32(uint32_t value);
+
+  WavFile();
+};
+
+
+#endif  // WAV_FILE_H
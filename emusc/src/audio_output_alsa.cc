@@ -114,10 +114,16 @@ void AudioOutputAlsa::_set_hwparams()
     throw(QString("[ALSA] Can't set interleaved mode. " +
     QString(snd_strerror(ret))));
 
-  // Set to signed 16-bit format
-  if (ret = snd_pcm_hw_params_set_format(_pcmHandle, hwParams,
-					 SND_PCM_FORMAT_S16_LE) < 0) 
-    throw(QString("[ALSA] Can't set format. " + QString(snd_strerror(ret))));
+  // Set to float format, fall back to signed 16-bit if not supported
+  _format = SND_PCM_FORMAT_FLOAT;
+  if ((ret = snd_pcm_hw_params_set_format(_pcmHandle, hwParams, _format)) < 0) {
+    int floatRet = ret;
+    _format = SND_PCM_FORMAT_S16;
+    if ((ret = snd_pcm_hw_params_set_format(_pcmHandle, hwParams, _format)) < 0)
+      throw(QString("[ALSA] Can't set format. Float: " +
+		    QString(snd_strerror(floatRet)) + " S16: " +
+		    QString(snd_strerror(ret))));
+  }
   
   // Set number of channels
   if (ret = snd_pcm_hw_params_set_channels(_pcmHandle, hwParams, 2) < 0)
@@ -185,25 +191,31 @@ void AudioOutputAlsa::_set_swparams()
 }
 
 
-// Only 16 bit supported
+// Float and signed 16 bit formats are supported
 int AudioOutputAlsa::_fill_buffer(const snd_pcm_channel_area_t *areas,
 				  snd_pcm_uframes_t offset,
 				  snd_pcm_uframes_t frames,
 				  EmuSC::Synth *synth)
 {
-  int16_t sample[_channels];
+  // Areas are interleaved, so whole period is rendered directly into buffer
+  char *dest = ((char*) areas[0].addr) + (areas[0].first >> 3) +
+               ((areas[0].step >> 3) * offset);
 
-  for (unsigned int frame = 0; frame < frames; frame++) {
-    synth->get_next_sample(sample);   // FIXME: Assumes 16 bit, 44.1 kHz, 2 ch
+  if (_format == SND_PCM_FORMAT_FLOAT) {
+    float *samples = (float *) dest;
+    synth->render(samples, frames);
 
-    for (int channel=0; channel < _channels; channel++) {
-      int16_t* dest =
-	(int16_t*) ( ((char*) areas[channel].addr)  
-		     + (areas[channel].first >> 3)
-		     + ( (areas[channel].step >> 3) * (offset + frame) ) );
+    if (_volume != 1)
+      for (unsigned int i = 0; i < frames * _channels; i++)
+	samples[i] *= _volume;
 
-      *dest = sample[channel] * _volume;
-    }
+  } else {
+    int16_t *samples = (int16_t *) dest;
+    synth->render(samples, frames);
+
+    if (_volume != 1)
+      for (unsigned int i = 0; i < frames * _channels; i++)
+	samples[i] *= _volume;
   }
 
   return 0;
@@ -219,9 +231,9 @@ void AudioOutputAlsa::start(void)
 
 void AudioOutputAlsa::run(void)
 {
-  snd_pcm_format_t format = SND_PCM_FORMAT_S16;
-  signed short *samples;
-  samples = (signed short *) malloc((_periodSize * _channels * snd_pcm_format_physical_width(format)) / 8);
+  int frameSize = _channels * snd_pcm_format_physical_width(_format) / 8;
+  char *samples;
+  samples = (char *) malloc(_periodSize * frameSize);
   if (samples == NULL) {
     std::cerr << "No enough memory" << std::endl;
     exit(EXIT_FAILURE);
@@ -237,12 +249,12 @@ void AudioOutputAlsa::run(void)
   unsigned int chn;
   for (chn = 0; chn < _channels; chn++) {
     areas[chn].addr = samples;
-    areas[chn].first = chn * snd_pcm_format_physical_width(format);
-    areas[chn].step = _channels * snd_pcm_format_physical_width(format);
+    areas[chn].first = chn * snd_pcm_format_physical_width(_format);
+    areas[chn].step = _channels * snd_pcm_format_physical_width(_format);
   }
 
   double phase = 0;
-  signed short *ptr;
+  char *ptr;
   int err, cptr;
  
   while (!_quit) {
@@ -261,7 +273,7 @@ void AudioOutputAlsa::run(void)
 	}
 	break;                                             // Skip one period
       }
-      ptr += err * _channels;
+      ptr += err * frameSize;
       cptr -= err;
     }
   }
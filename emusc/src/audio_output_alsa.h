@@ -54,6 +54,8 @@ private:
 
   snd_pcm_sframes_t _bufferSize;
   snd_pcm_sframes_t _periodSize;
+
+  snd_pcm_format_t _format;       // Float if supported by device, else S16
   
   std::string _deviceName;
   
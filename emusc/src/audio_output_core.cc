@@ -67,22 +67,22 @@ AudioOutputCore::AudioOutputCore(EmuSC::Synth *synth)
 
   AudioStreamBasicDescription aFormat = {0};
   aFormat.mFormatID = kAudioFormatLinearPCM;
-  aFormat.mFormatFlags = kLinearPCMFormatFlagIsPacked;
-  aFormat.mChannelsPerFrame = 2;
-  aFormat.mSampleRate = 44100;
-  aFormat.mFramesPerPacket = 1;
-  aFormat.mBitsPerChannel = 16;
-  aFormat.mBytesPerFrame = aFormat.mChannelsPerFrame*aFormat.mBitsPerChannel/8;
+  aFormat.mFormatFlags = kAudioFormatFlagsNativeFloatPacked |
+                         kAudioFormatFlagIsNonInterleaved;
+  aFormat.mChannelsPerFrame = _channels;
+  aFormat.mSampleRate = _sampleRate;
   aFormat.mFramesPerPacket = 1;
+  aFormat.mBitsPerChannel = 32;
+  aFormat.mBytesPerFrame = aFormat.mBitsPerChannel / 8;   // Non-interleaved
   aFormat.mBytesPerPacket = aFormat.mBytesPerFrame * aFormat.mFramesPerPacket;
-  /*
+
   result = AudioUnitSetProperty(_audioUnit,
 				kAudioUnitProperty_StreamFormat,
 				kAudioUnitScope_Input, 0,
 				&aFormat, sizeof(aFormat));
   if (result != noErr)
     throw (QString("Couldn't set the data format for CoreAudio unit"));
-  */
+
   AURenderCallbackStruct rCallback;
   rCallback.inputProc = this->callback;
   rCallback.inputProcRefCon = this;
@@ -121,26 +121,23 @@ OSStatus AudioOutputCore::_callback(AudioUnitRenderActionFlags *ioActionFalgs,
 }
 
 
-// Only 16 bit supported
+// Stream format is non-interleaved float, so the synth renders directly into
+// the channel buffers
 int AudioOutputCore::_fill_buffer(AudioBufferList *data, UInt32 frames)
 {
-  int i = 0;
-  int16_t sample[_channels];
-
   Float32 *left = (Float32 *) data->mBuffers[0].mData;
   Float32 *right = (Float32 *) data->mBuffers[1].mData;
-	  
-  for (unsigned int frame = 0; frame < frames; frame++) {
-    _synth->get_next_sample(sample);
-    *left = (Float32) sample[0] / (1 << 15) * _volume;
-    *right = (Float32) sample[1] / (1 << 15) * _volume;
-
-    left++;
-    right++;
-    i ++;
+
+  _synth->render(left, right, frames);
+
+  if (_volume != 1) {
+    for (unsigned int frame = 0; frame < frames; frame++) {
+      left[frame] *= _volume;
+      right[frame] *= _volume;
+    }
   }
 
-  return i;
+  return frames;
 }
 
 
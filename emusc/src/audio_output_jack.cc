@@ -87,25 +87,21 @@ int AudioOutputJack::callback(jack_nframes_t nframes, void *arg)
 }
 
 
-// TODO: Add support for float directly from synth->get_next_sample() to avoid
-//       unnecessary conversion float -> int16 -> float
+// JACK uses non-interleaved float buffers, so the synth renders directly into
+// the port buffers
 int AudioOutputJack::_fill_buffer(jack_nframes_t nframes)
 {
-  int16_t sample[_channels];
-
   jack_default_audio_sample_t *out[_channels];
   for (int i = 0; i < _channels; i ++)
     out[i] = (jack_default_audio_sample_t *) jack_port_get_buffer(_port[i],
 								  nframes);
 
-  for (unsigned int frame = 0; frame < nframes; frame++) {
-    _synth->get_next_sample(sample);
+  _synth->render(out[0], out[1], nframes);
 
-    for (int i = 0; i < _channels; i ++) {      
-      float *o = (float *) (out[i] + frame);
-      *o =  (float) sample[i] / (1 << 15) * _volume;
-    }
-  }
+  if (_volume != 1)
+    for (int i = 0; i < _channels; i ++)
+      for (unsigned int frame = 0; frame < nframes; frame++)
+	out[i][frame] *= _volume;
 
   return 0;
 }
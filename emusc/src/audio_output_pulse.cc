@@ -44,7 +44,7 @@ AudioOutputPulse::AudioOutputPulse(EmuSC::Synth *synth)
   // Set sample specification
   _sampleSpec.rate = _sampleRate;
   _sampleSpec.channels = _channels;
-  _sampleSpec.format = PA_SAMPLE_S16NE;
+  _sampleSpec.format = PA_SAMPLE_FLOAT32NE;
 
   if (!pa_sample_spec_valid(&_sampleSpec))
     throw (QString("Pulse error: Sample spec invalid"));
@@ -172,25 +172,15 @@ void AudioOutputPulse::_stream_write_callback(pa_stream *s, size_t length)
 }
 
 
-// Only 16 bit supported
+// Stream format is interleaved float
 int AudioOutputPulse::_fill_buffer(int8_t *data, size_t length)
 {
-  int i = 0;
-  int16_t sample[_channels];
+  int frameSize = sizeof(float) * _channels;
+  int frames = length / frameSize;
 
-  int frames = length / 4;
-  
-  for (unsigned int frame = 0; frame < frames; frame++) {
-    _synth->get_next_sample(sample);  // FIXME: Assumes 16 bit, 44.1 kHz, 2 ch
-
-    for (int channel=0; channel < _channels; channel++) {
-      int16_t* dest = (int16_t *) &data[(frame * 4) + (2 * channel)];
-      *dest = sample[channel];
-      i += 2;
-    }
-  }
+  _synth->render((float *) data, frames);
 
-  return i;
+  return frames * frameSize;
 }
 
 
@@ -145,22 +145,11 @@ void SynthGen::stop()
 
 qint64 SynthGen::readData(char *data, qint64 length)
 {
-  int i = 0;
-  int16_t sample[_channels];
-
   int frames = length / 4;
 
-  for (unsigned int frame = 0; frame < frames; frame++) {
-    _synth->get_next_sample(sample);
-
-    for (int channel = 0; channel < _channels; channel++) {
-      int16_t* dest = (int16_t *) &data[(frame * 4) + (2 * channel)];
-      *dest = sample[channel];
-      i += 2;
-    }
-  }
+  _synth->render((int16_t *) data, frames);
 
-  return i;
+  return frames * 4;
 }
 
 qint64 SynthGen::writeData(const char *data, qint64 len)
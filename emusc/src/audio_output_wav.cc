@@ -68,22 +68,11 @@ AudioOutputWav::~AudioOutputWav()
 // FIXME: Assumes 16 bit, 44.1 kHz, 2 ch
 int AudioOutputWav::_fill_buffer(int8_t *data, size_t length)
 {
-  int i = 0;
-  int16_t sample[_channels];
-
   int frames = length / 4;
-  
-  for (unsigned int frame = 0; frame < frames; frame++) {
-    _synth->get_next_sample(sample);
-
-    for (int channel = 0; channel < _channels; channel++) {
-      int16_t* dest = (int16_t *) &data[(frame * 4) + (2 * channel)];
-      *dest = sample[channel];
-      i += 2;
-    }
-  }
 
-  return i;
+  _synth->render((int16_t *) data, frames);
+
+  return frames * 4;
 }
 
 
@@ -124,21 +113,22 @@ void AudioOutputWav::run(void)
   std::chrono::high_resolution_clock::time_point t1;
   std::chrono::high_resolution_clock::time_point t2;
   std::chrono::duration<double> timeDiff;
-  std::chrono::duration<double, std::ratio<1, 44100>> timePerSample;
+  // Audio is rendered in chunks of 256 frames (size of data buffer)
+  std::chrono::duration<double, std::ratio<1, 44100>> timePerBuffer(sizeof(data) / bytesPerSample);
   t1 = std::chrono::high_resolution_clock::now();
 
   while(!_quit) {
     t2 = std::chrono::high_resolution_clock::now();
     timeDiff = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1);
 
-    std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(timePerSample - timeDiff));
+    std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(timePerBuffer - timeDiff));
     
-    int len = _fill_buffer(&data[0], 4);
+    int len = _fill_buffer(&data[0], sizeof(data));
     QByteArray dataArray = QByteArray::fromRawData((const char *)&data[0], len);
     wavFile.write(dataArray);
     numSamples += len / 4;
 
-    t1 += std::chrono::nanoseconds(22676);   // 22676 = ns per sample (44.1kHz)
+    t1 += std::chrono::duration_cast<std::chrono::nanoseconds>(timePerBuffer);
   }
 
   // Update WAV header with correct sizes before closing the file
@@ -188,22 +188,16 @@ void AudioOutputWin32::stop(void)
 // Only 16 bit supported
 int AudioOutputWin32::_fill_buffer(char *audioBuffer)
 {
-  int i = 0;
-  int16_t sample[_channels];
-
   int frames = _bufferSize / (2 * _channels);
-  
-  for (unsigned int frame = 0; frame < frames; frame++) {
-    _synth->get_next_sample(sample);
-    
-    for (int channel=0; channel < _channels; channel++) {
-      int16_t* dest = (int16_t*) &audioBuffer[(frame * 4) + (2 * channel)];
-      *dest = sample[channel] * _volume;
-      i += 2;
-    }
-  }
+  int16_t *samples = (int16_t *) audioBuffer;
+
+  _synth->render(samples, frames);
+
+  if (_volume != 1)
+    for (int i = 0; i < frames * _channels; i++)
+      samples[i] *= _volume;
 
-  return i;
+  return frames * _channels * 2;
 }
 
 
@@ -263,12 +263,16 @@ void Emulator::lcd_display_init_complete(void)
 }
 
 
+// Called from the audio render thread, so defer user interface updates to the
+// Qt event loop
 void Emulator::_part_mod_callback(const int partId)
 {
-  if (partId == _selectedPart && !_allMode)
-    _set_part(partId);
-  else if (partId < 0 && _allMode)
-    _set_all();
+  QMetaObject::invokeMethod(this, [this, partId]() {
+    if (partId == _selectedPart && !_allMode)
+      _set_part(partId);
+    else if (partId < 0 && _allMode)
+      _set_all();
+  }, Qt::QueuedConnection);
 }
 
 
@@ -1365,7 +1369,7 @@ void Emulator::play_note(uint8_t key, uint8_t velocity)
 }
 
 
-std::vector<EmuSC::ControlRom::DrumSet> &Emulator::get_drumsets_ref(void)
+const std::vector<EmuSC::ControlRom::DrumSet> &Emulator::get_drumsets_ref(void)
 {
   return _emuscControlRom->get_drumsets_ref();
 }
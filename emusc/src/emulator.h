@@ -159,7 +159,7 @@ public slots:
 
   void play_note(uint8_t key, uint8_t velocity);
 
-  std::vector<EmuSC::ControlRom::DrumSet> &get_drumsets_ref(void);
+  const std::vector<EmuSC::ControlRom::DrumSet> &get_drumsets_ref(void);
 
   void update_LCD_display(int8_t part = -1);
 
@@ -27,9 +27,14 @@
 namespace EmuSC {
 
 
-AHDSR::AHDSR(double value[5], uint8_t duration[5], bool shape[5], int key, Settings *settings, int8_t partId, std::string id)
+const std::array<float, 128> AHDSR::_timeTable = AHDSR::_init_time_table();
+
+
+AHDSR::AHDSR(double value[5], uint8_t duration[5], bool shape[5], int key, Settings *settings, int8_t partId, const char *id)
   : _id(id),
     _sampleRate(settings->get_param_uint32(SystemParam::SampleRate)),
+    _controlPeriod(settings->get_param(SystemParam::ControlPeriod)),
+    _ramp(0),
     _key(key),
     _settings(settings),
     _partId(partId),
@@ -73,9 +78,11 @@ AHDSR::AHDSR(double value[5], uint8_t duration[5], bool shape[5], int key, Setti
 }
 
 
-AHDSR::AHDSR(double init, double value[5], uint8_t duration[5], Settings *settings, int8_t partId, std::string id)
+AHDSR::AHDSR(double init, double value[5], uint8_t duration[5], Settings *settings, int8_t partId, const char *id)
   : _id(id),
     _sampleRate(settings->get_param_uint32(SystemParam::SampleRate)),
+    _controlPeriod(settings->get_param(SystemParam::ControlPeriod)),
+    _ramp(init),
     _key(-1),
     _settings(settings),
     _partId(partId),
@@ -161,10 +168,34 @@ void AHDSR::_init_new_phase(enum Phase newPhase)
 
   double phaseDurationSec = _convert_time_to_sec((int8_t) durationTotal, _key);
   _phaseSampleLen = round(phaseDurationSec * _sampleRate);
-
-  _phaseSampleIndex = 0;
+  _phaseSamplesLeft = _phaseSampleLen;
   _phase = newPhase;
-  
+
+  // Set up the recurrence from current value towards the phase value. Shapes
+  // are read one phase behind, with attack using the same shape as hold.
+  double delta = _phaseValue[_phase] - _phaseInitValue;
+  _phaseLog = _phaseShape[(_phase > 0) ? _phase - 1 : 0];
+
+  if (_phaseSampleLen <= 0) {
+    _phaseLog = false;
+    _base = _phaseValue[_phase];
+    _offset = 0;
+    _step = _tickStep = 0;
+
+  } else if (!_phaseLog) {                          // Linear
+    _base = 0;
+    _offset = _phaseInitValue;
+    _step = delta / _phaseSampleLen;
+    _tickStep = _step * _controlPeriod;
+
+  } else {                                          // Concave / convex
+    double scale = delta / (1 - exp(-_logShape));
+    _base = _phaseInitValue + scale;
+    _offset = -scale;
+    _step = exp(-_logShape / _phaseSampleLen);
+    _tickStep = pow(_step, _controlPeriod);
+  }
+
   if (0)
     std::cout << "New " << _id << " envelope phase: -> " << _phase
 	      << " (" << _phaseName[_phase] << ")"
@@ -176,59 +207,100 @@ void AHDSR::_init_new_phase(enum Phase newPhase)
 
 
 // TODO: Change this to use the LUT found in the control ROM
-// The function used instead is a good approximation proposed by Kitrinx
+// None of the LUTs read by ControlRom::lookup_table() has been identified as
+// the envelope time table yet, so the table is filled with a good
+// approximation proposed by Kitrinx
+std::array<float, 128> AHDSR::_init_time_table(void)
+{
+  std::array<float, 128> table;
+  for (int i = 0; i < 128; i++)
+    table[i] = pow(2.0, (double) i / 18.0) / 5.45 - 0.183;
+
+  return table;
+}
+
+
 double AHDSR::_convert_time_to_sec(uint8_t time, int key)
 {
   if (key < 0)
-    return (pow(2.0, (double)(time) / 18.0) / 5.45 - 0.183);
+    return _timeTable[time];
 
-  return (pow(2.0, (double)(time) / 18.0) / 5.45 - 0.183) * (1 - (key / 128.0));
+  return _timeTable[time] * (1 - (key / 128.0));
 }
 
 
+// Envelope values are calculated at control rate and ramped linearly between
 double AHDSR::get_next_value(void)
+{
+  if (_ramp.update_needed())
+    _ramp.set_target(_advance(), _controlPeriod);
+
+  return _ramp.next();
+}
+
+
+// Move envelope forward a number of frames within the current phase
+void AHDSR::_skip(int32_t frames)
+{
+  if (_phaseLog)
+    _offset *= pow(_step, frames);
+  else
+    _offset += _step * frames;
+
+  _phaseSamplesLeft -= frames;
+}
+
+
+// Move envelope forward one control period and return the new value. Each
+// phase is a linear (additive) or logarithmic (multiplicative) recurrence, so
+// only one addition or multiplication is needed for each period.
+double AHDSR::_advance(void)
 {
   if (_phase == ahdsr_Off) {
     std::cerr << "libEmuSC: Internal error, envelope used in Off phase"
 	      << std::endl; 
     return 0;
+  }
+
+  if (_finished)
+    return 0;
 
-  } else if (_phase == ahdsr_Attack) {
-    if (_phaseSampleIndex > _phaseSampleLen)
+  if (_phaseLog)
+    _offset *= _tickStep;
+  else
+    _offset += _tickStep;
+  _phaseSamplesLeft -= _controlPeriod;
+
+  // Start next phase, keeping any frames passed the end of the current phase
+  while (_phaseSamplesLeft <= 0) {
+    int32_t overshoot = -_phaseSamplesLeft;
+    _currentValue = _phaseValue[_phase];
+
+    if (_phase == ahdsr_Attack) {
       _init_new_phase(ahdsr_Hold);
 
-  } else if (_phase == ahdsr_Hold) {
-    if (_phaseSampleIndex > _phaseSampleLen)
+    } else if (_phase == ahdsr_Hold) {
       _init_new_phase(ahdsr_Decay);
 
-  } else if (_phase == ahdsr_Decay) {
-    if (_phaseSampleIndex > _phaseSampleLen)
+    } else if (_phase == ahdsr_Decay) {
       _init_new_phase(ahdsr_Sustain);
 
-  } else if (_phase == ahdsr_Sustain) {
-    if (_phaseSampleIndex > _phaseSampleLen)
-      if (_phaseValue[ahdsr_Sustain] == 0)
-	_init_new_phase(ahdsr_Release);
-      else
+    } else if (_phase == ahdsr_Sustain) {
+      if (_phaseValue[ahdsr_Sustain] != 0) {
+	_phaseSamplesLeft = 0;
 	return _currentValue;                  // Sustain can last forever
+      }
+      _init_new_phase(ahdsr_Release);
 
-  } else if (_phase == ahdsr_Release) {
-    if (_phaseSampleIndex > _phaseSampleLen) {
+    } else {
       _finished = true;
       return 0;
     }
+
+    _skip(overshoot);
   }
 
-  if (_phaseSampleLen <= 0)
-    _currentValue = _phaseValue[_phase];
-  else if (_phaseShape[_phase - 1] == 0)            // Linear
-    _currentValue = _phaseInitValue +
-      (_phaseValue[_phase] - _phaseInitValue) *
-      ((double) _phaseSampleIndex / (double) _phaseSampleLen);
-  else
-    _currentValue = _phaseInitValue +                // Concave / convex
-      (_phaseValue[_phase] - _phaseInitValue) *
-      (log(10.0 * _phaseSampleIndex / _phaseSampleLen + 1) / log(10.0 + 1));
+  _currentValue = _base + _offset;
 
   /*
   // Debug output to file for plotting in Octave
@@ -242,8 +314,6 @@ double AHDSR::get_next_value(void)
   _sampleNum ++;
   */
 
-  _phaseSampleIndex ++;
-
   return _currentValue;
 }
 
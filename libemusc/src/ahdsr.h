@@ -21,11 +21,12 @@
 #define __AHDSR_H__
 
 
+#include "control_ramp.h"
 #include "settings.h"
 
 #include <stdint.h>
 
-#include <string>
+#include <array>
 
 
 namespace EmuSC {
@@ -34,8 +35,8 @@ namespace EmuSC {
 class AHDSR
 {
 public:
-  AHDSR(double value[5], uint8_t duration[5], bool shape[5], int key, Settings *settings, int8_t partId, std::string id);
-  AHDSR(double init, double value[5], uint8_t duration[5], Settings *settings, int8_t partId, std::string id);
+  AHDSR(double value[5], uint8_t duration[5], bool shape[5], int key, Settings *settings, int8_t partId, const char *id);
+  AHDSR(double init, double value[5], uint8_t duration[5], Settings *settings, int8_t partId, const char *id);
   ~AHDSR();
 
   void start(void);
@@ -44,6 +45,11 @@ public:
 
   inline bool finished(void) { return _finished; }
 
+  // Current envelope level. During attack the attack target is returned, so
+  // notes that have just started are not mistaken for quiet notes.
+  inline double level(void)
+  { return (_phase == ahdsr_Attack) ? _phaseValue[ahdsr_Attack]:_currentValue; }
+
 private:
   double  _phaseValue[5];
   uint8_t _phaseDuration[5];
@@ -52,11 +58,20 @@ private:
   bool _finished;               // Flag indicating whether enveolope is finished
 
   uint32_t _sampleRate;
+  uint32_t _controlPeriod;      // Frames between each envelope calculation
+  ControlRamp _ramp;
+
+  int32_t _phaseSampleLen;
+  int32_t _phaseSamplesLeft;
+
+  // Envelope value is _base + _offset. Linear phases add a fixed step to
+  // _offset, while logarithmic phases multiply it with a fixed factor.
+  bool _phaseLog;
+  double _base;
+  double _offset;
+  double _step;                 // Per frame step or factor
+  double _tickStep;             // Step or factor for one control period
 
-  uint32_t _phaseSampleIndex;
-  uint32_t _phaseSampleNum;
-  uint32_t _phaseSampleLen;
-  
   double _phaseInitValue;
   double _currentValue;
 
@@ -76,15 +91,25 @@ private:
   Settings *_settings;
   int8_t _partId;
 
-  std::string _id;
+  const char *_id;             // Envelope name for debug output
   const char *_phaseName[5] = { "Attack", "Hold", "Decay",
 				"Sustain", "Release" };
 
   AHDSR();
 
   void _init_new_phase(enum Phase newPhase);
+  void _skip(int32_t frames);
+  double _advance(void);
   double _convert_time_to_sec(uint8_t time, int key = -1);
 
+  // Phase duration in seconds for time values 0 - 127
+  static const std::array<float, 128> _timeTable;
+  static std::array<float, 128> _init_time_table(void);
+
+  // Shape of logarithmic phases, 1 - e^(-a * x) scaled to [0, 1]. The value
+  // minimizes the deviation from log(10x + 1) / log(11), which is below 4.3%.
+  static constexpr double _logShape = 2.6;
+
 //  uint32_t _sampleNum;
 //  std::ofstream _ofs;
 
@@ -19,12 +19,9 @@
 
 #include "chorus.h"
 
-#include <iostream>
-#include <vector>
+#include <algorithm>
 #include <cmath>
 
-#include <iomanip>
-
 #ifndef M_PI
     #define M_PI 3.14159265358979323846
 #endif
@@ -36,21 +33,29 @@ namespace EmuSC {
 Chorus::Chorus(Settings *settings)
   : _settings(settings),
     _sampleRate(settings->get_param_uint32(SystemParam::SampleRate)),
-    _stereoWidth(0.5),
-    _lfoPhase(0),
-    _lpFilter(_sampleRate),
-    _numVoices(1),
-    _writeIndex(0)
+    _preLPF(0xff),
+    _writeIndex(0),
+    _lfoLeft(WaveGenerator::Waveform::triangle, _sampleRate),
+    _lfoRight(WaveGenerator::Waveform::triangle, _sampleRate),
+    _lpFilter(_sampleRate)
 {
-  _delayLineSize = _sampleRate * 0.2;             // Max 100ms delay
-
-  _delayLinesLeft.reserve(_numVoices);
-  _delayLinesRight.reserve(_numVoices);
-  
-  for (int i = 0; i < _numVoices; ++i) {
-    _delayLinesLeft.push_back(std::vector<float>(_delayLineSize, 0.0f));
-    _delayLinesRight.push_back(std::vector<float>(_delayLineSize, 0.0f));
-  }
+  // Max 200ms delay, rounded up to a power of 2
+  uint32_t frames = 1;
+  while (frames < _sampleRate * 0.2)
+    frames <<= 1;
+
+  _delayLine.assign(frames * 2, 0);
+  _delayLineMask = frames - 1;
+
+  uint8_t controlPeriod = settings->get_param(SystemParam::ControlPeriod);
+  _lfoLeft.set_control_period(controlPeriod);
+  _lfoRight.set_control_period(controlPeriod);
+  _lfoRight.set_phase(0.25);
+
+  // TODO: Verify stereo width
+  float stereoWidth = 0.5;
+  _panL = std::cos(0.5 * M_PI * stereoWidth);
+  _panR = std::sin(0.5 * M_PI * stereoWidth);
 }
 
 
@@ -58,111 +63,89 @@ Chorus::~Chorus()
 {}
 
 
-// Process a single audio sample
-void Chorus::process_sample(float input, float *output)
+// Chorus parameters are only read once per block
+void Chorus::_update_params(void)
 {
   // TODO: Figure out proper depth levels. Linear increase?
-  _depth = 1.4 *_settings->get_param(PatchParam::ChorusDepth);
+  _depth = 1.4 * _settings->get_param(PatchParam::ChorusDepth) * 0.0001 *
+    _sampleRate;
 
   // TODO: Figure out proper values for feedback. Linear increase?
   _feedback = _settings->get_param(PatchParam::ChorusFeedback) / 165.0;
 
   // TODO: How is the f(x) for Chorus delay? Linear function 0 - 100 ms?
-  _delay = (_sampleRate / 8192.0) * _settings->get_param(PatchParam::ChorusDelay);
+  _delay = (_sampleRate / 8192.0) *
+    _settings->get_param(PatchParam::ChorusDelay) * 0.0001 * _sampleRate;
 
   // Chorus rate measured on an SC-55 MkII.
   //  - Linear in the range 0 > rate > 105: y = rate / 8
   //  - Flat when rate > 105: y = 105 / 8
   int chorusRate = _settings->get_param(PatchParam::ChorusRate);
   _rate = chorusRate <= 105 ? chorusRate / 8.0 : 105 / 8.0;
+  _lfoLeft.set_frequency(_rate);
+  _lfoRight.set_frequency(_rate);
 
-  // Run through pre lowpass filter
   // TODO: This seems to be a single order lowpass filter?
-  _preLPF = _settings->get_param(PatchParam::ChorusPreLPF);
-  _lpFilter.calculate_coefficients(_lpCutoffFreq[_preLPF], 0.707);
-  float filteredInput = _lpFilter.apply(input);
-
-  // Create delayed and detuned voices for left channel
-  float outputL = 0.0f;
-
-  // Calculate modulation for left channel
-  double modDepthL = _depth * (4.0 * std::fabs(_lfoPhase - 0.5));  // - 1.0);  
-  float modDelayTimeL = (_delay + modDepthL) * 0.0001;
-  int modDelaySamplesL = std::round(modDelayTimeL * _sampleRate);
-
-  for (int i = 0; i < _numVoices; ++i) {
-    int _readIndex = fmod(_writeIndex + _delayLineSize - modDelaySamplesL,
-			  _delayLineSize);
-    if (0) {
-      static int b=0;
-      if (++b % 10000 == 0)
-	std::cout << std::fixed << std::setprecision(1)
-		  << " ri=" << std::setw(4) << _readIndex
-		  << " wi=" << std::setw(4) << _writeIndex
-		  << " md=" << std::setw(5) << modDepthL
-		  << " mdt=" << std::setw(7) << std::setprecision(4) << modDelayTimeL
-		  << " mds=" << std::setw(4) << modDelaySamplesL
-		  << " dls=" << std::setw(4) << _delayLineSize
-		  << " dly=" << std::setw(5) << std::setprecision(1) << _delay
-		  << " dpt=" << std::setw(5) << _depth
-		  << std::endl;
-    }
+  uint8_t preLPF = _settings->get_param(PatchParam::ChorusPreLPF) & 0x07;
+  if (preLPF != _preLPF) {
+    _preLPF = preLPF;
+    _lpFilter.calculate_coefficients(_lpCutoffFreq[_preLPF], 0.707);
+  }
 
-    float delayedSample = _delayLinesLeft[i][_readIndex];
-    _delayLinesLeft[i][_writeIndex] = filteredInput + delayedSample * _feedback;
+  _tail.set_length(EffectTail::feedback_length(_delay + 2 * _depth + 1,
+					       _feedback));
+}
 
-    outputL += delayedSample;
-  }
 
-  // Create delayed and detuned voices for right channel
-  float outputR = 0.0f;
+// Both channels share the same input and delay line position, but are
+// modulated by separate LFOs. Delayed samples are read with linear
+// interpolation between the two nearest frames to avoid zipper noise.
+bool Chorus::process_block(const float *input, float *output, uint32_t frames)
+{
+  if (!_tail.update(input, frames))
+    return false;
 
-  // Create LFO signal 90 degree phase adjusted for right channel. TODO: Verify
-  float lfoPhase90 = _lfoPhase + 0.25;
-  if (lfoPhase90 >= 1.0)
-    lfoPhase90 -= 1.0;
+  _update_params();
 
-  // Calculate modulation for right channel
-  float modDepthR = _depth * (4.0 * std::fabs(lfoPhase90 - 0.5));  // - 1.0);  
-  float modDelayTimeR = (_delay + modDepthR) * 0.0001;
-  float modDelaySamplesR = std::round(modDelayTimeR * _sampleRate);
+  _lfoLeft.next_block(frames);
+  _lfoRight.next_block(frames);
 
-  for (int i = 0; i < _numVoices; ++i) {
-    int _readIndex = fmod(_writeIndex + _delayLineSize - modDelaySamplesR,
-			  _delayLineSize);
+  float *line = _delayLine.data();
+  const uint32_t mask = _delayLineMask;
+  const float maxDelay = mask - 1;
 
-    float delayedSample = _delayLinesRight[i][_readIndex];
-    _delayLinesRight[i][_writeIndex] = filteredInput + delayedSample * _feedback;
-    outputR += delayedSample;
-  }
+  for (uint32_t i = 0; i < frames; i++) {
+    float filteredInput = _lpFilter.apply(input[i]);
+    float lfo[2] = { _lfoLeft.value(i), _lfoRight.value(i) };
+    float out[2];
 
-  // Normalize output
-  output[0] = outputL / _numVoices;
-  output[1] = outputR / _numVoices;
+    for (int ch = 0; ch < 2; ch++) {
+      float delay = _delay + _depth * (1 + lfo[ch]);
+      delay = std::min(std::max(delay, 1.0f), maxDelay);
 
-  // Apply stereo width
-  apply_stereo_width(output);
+      // Read position is kept positive by adding the delay line size
+      float readPos = _writeIndex + (mask + 1) - delay;
+      uint32_t index = (uint32_t) readPos;
+      float fraction = readPos - index;
 
-  // Update LFO
-  _lfoPhase += _rate / _sampleRate;
-  if (_lfoPhase >= 1.0)
-    _lfoPhase -= 1.0;
+      float s0 = line[(index & mask) * 2 + ch];
+      float s1 = line[((index + 1) & mask) * 2 + ch];
+      out[ch] = s0 + fraction * (s1 - s0);
 
-  _writeIndex = (_writeIndex + 1) % _delayLineSize;
-}
+      line[_writeIndex * 2 + ch] = filteredInput + out[ch] * _feedback;
+    }
 
+    // Apply stereo width using a simple panning function
+    float mid = 0.5f * (out[0] + out[1]);
+    float side = 0.5f * (out[0] - out[1]);
 
-// Apply stereo width using a simple panning function
-void Chorus::apply_stereo_width(float *output)
-{
-  float panL = std::cos(0.5 * M_PI * _stereoWidth);
-  float panR = std::sin(0.5 * M_PI * _stereoWidth);
+    output[i * 2] = _panL * mid + _panR * side;
+    output[i * 2 + 1] = _panR * mid - _panL * side;
 
-  float mid = 0.5f * (output[0] + output[1]);
-  float side = 0.5f * (output[0] - output[1]);
+    _writeIndex = (_writeIndex + 1) & mask;
+  }
 
-  output[0] = panL * mid + panR * side;
-  output[1] = panR * mid - panL * side;
+  return true;
 }
 
 }
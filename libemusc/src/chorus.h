@@ -21,9 +21,12 @@
 #define __CHORUS_H__
 
 
+#include "effect_tail.h"
 #include "lowpass_filter.h"
 #include "settings.h"
+#include "wave_generator.h"
 
+#include <array>
 #include <vector>
 
 
@@ -35,8 +38,9 @@ class Chorus
   Chorus(Settings *settings);
   ~Chorus();
 
-  void process_sample(float input, float *output);
-  void apply_stereo_width(float *output);
+  // Process a block of mono input and write interleaved stereo output.
+  // Returns false without writing any output if the effect is bypassed.
+  bool process_block(const float *input, float *output, uint32_t frames);
 
 
  private:
@@ -44,27 +48,33 @@ class Chorus
 
   Settings *_settings;
 
-  int _numVoices;     // = 3 Number of chorus voices
-  int _delayLineSize; // = 8192;  // Size of each delay line
-
   uint32_t _sampleRate;
   uint8_t _preLPF;             // Lowpass filter before chorus, 250Hz - 8kHz?
   float _rate;                 // Modulation rate (LFO), 0.05 - 10Hz?
-  float _depth;                // Modulation depth (LFO), 1 - 20 cents?
-  float _delay;                // Time delay in num of samples, 0, 1.0 ,100 ms?
+  float _depth;                // Modulation depth in samples
+  float _delay;                // Time delay in samples
   float _feedback;             // Feedback, 0 - 0.96?
 
-  float _stereoWidth;
-  std::vector<std::vector<float>> _delayLinesLeft;
-  std::vector<std::vector<float>> _delayLinesRight;
+  // Stereo width is fixed, so pan factors are only calculated once
+  float _panL;
+  float _panR;
 
-  int _writeIndex;
+  // Interleaved stereo delay line. Size is a power of 2 so that read and
+  // write positions can wrap around with a mask.
+  std::vector<float> _delayLine;
+  uint32_t _delayLineMask;     // Number of frames - 1
+  uint32_t _writeIndex;
 
-  float _lfoPhase;
+  // Triangle LFOs, right channel is 90 degrees ahead of left channel
+  WaveGenerator _lfoLeft;
+  WaveGenerator _lfoRight;
 
   LowPassFilter _lpFilter;
+  EffectTail _tail;
   std::array<int, 8> _lpCutoffFreq = { 8000, 5000, 3150, 2000,
 				       1250, 800, 400, 250 };
+
+  void _update_params(void);
 };
 
 }
@@ -0,0 +1,77 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Linear ramp for modulation sources (LFOs, envelopes) that are evaluated at
+// control rate, i.e. once every N frames. The source calculates its value N
+// frames ahead, and the ramp moves linearly towards it over the next N frames.
+// With a control period of 1 frame the ramp is bypassed and the source value
+// is used directly for every frame.
+
+
+#ifndef __CONTROL_RAMP_H__
+#define __CONTROL_RAMP_H__
+
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+
+class ControlRamp
+{
+public:
+  ControlRamp(double value = 0)
+    : _value(value),
+      _step(0),
+      _counter(0)
+  {}
+
+  // True when the source must calculate the value for the next period
+  inline bool update_needed(void) { return _counter == 0; }
+
+  inline void set_target(double target, uint32_t period)
+  {
+    if (period <= 1) {
+      _value = target;
+      _step = 0;
+      _counter = 1;
+    } else {
+      _step = (target - _value) / period;
+      _counter = period;
+    }
+  }
+
+  inline double next(void)
+  {
+    _value += _step;
+    _counter--;
+    return _value;
+  }
+
+  inline double value(void) { return _value; }
+
+private:
+  double _value;
+  double _step;
+  uint32_t _counter;
+};
+
+}
+
+#endif  // __CONTROL_RAMP_H__
@@ -84,7 +84,7 @@ ControlRom::~ControlRom()
 {}
 
 
-uint16_t ControlRom::_native_endian_uint16(uint8_t *ptr)
+uint16_t ControlRom::_native_endian_uint16(uint8_t *ptr) const
 {
   if (_le_native())
     return (ptr[0] << 8 | ptr[1]);
@@ -93,7 +93,7 @@ uint16_t ControlRom::_native_endian_uint16(uint8_t *ptr)
 }
 
 
-uint32_t ControlRom::_native_endian_3bytes_uint32(uint8_t *ptr)
+uint32_t ControlRom::_native_endian_3bytes_uint32(uint8_t *ptr) const
 {
   uint32_t result = 0;
   uint8_t *result_ptr = (uint8_t *) &result;
@@ -112,7 +112,7 @@ uint32_t ControlRom::_native_endian_3bytes_uint32(uint8_t *ptr)
 }
 
 
-uint32_t ControlRom::_native_endian_4bytes_uint32(uint8_t *ptr)
+uint32_t ControlRom::_native_endian_4bytes_uint32(uint8_t *ptr) const
 {
   uint32_t result = 0;
   uint8_t *result_ptr = (uint8_t *) &result;
@@ -206,7 +206,7 @@ int ControlRom::_identify_model(std::ifstream &romFile)
 }
 
 
-const std::vector<uint32_t> &ControlRom::_banks(void)
+const std::vector<uint32_t> &ControlRom::_banks(void) const
 {
   switch(_synthModel)
     {
@@ -520,7 +520,7 @@ int ControlRom::_read_lookup_tables(std::ifstream &romFile)
 }
 
 
-const std::vector<int>& ControlRom::drum_set_bank(void)
+const std::vector<int>& ControlRom::drum_set_bank(void) const
 {
   switch (_synthModel)
     {
@@ -540,7 +540,7 @@ const std::vector<int>& ControlRom::drum_set_bank(void)
 }
 
 
-const uint8_t ControlRom::max_polyphony(void)
+const uint8_t ControlRom::max_polyphony(void) const
 {
   switch (_synthModel)
     {
@@ -560,7 +560,7 @@ const uint8_t ControlRom::max_polyphony(void)
 }
 
 
-int ControlRom::dump_demo_songs(std::string path)
+int ControlRom::dump_demo_songs(std::string path) const
 {
   int index = 1;
   std::cout << "EmuSC: Searching for MIDI songs in control ROM..." << std::endl;
@@ -643,7 +643,7 @@ int ControlRom::dump_demo_songs(std::string path)
 }
 
 
-std::vector<std::vector<std::string>> ControlRom::get_instruments_list(void)
+std::vector<std::vector<std::string>> ControlRom::get_instruments_list(void) const
 {
   std::vector<std::vector<std::string>> instListVector;
 
@@ -666,7 +666,7 @@ std::vector<std::vector<std::string>> ControlRom::get_instruments_list(void)
 }
 
 
-std::vector<std::vector<std::string>> ControlRom::get_partials_list(void)
+std::vector<std::vector<std::string>> ControlRom::get_partials_list(void) const
 {
   std::vector<std::vector<std::string>> partListVector;
 
@@ -693,7 +693,7 @@ std::vector<std::vector<std::string>> ControlRom::get_partials_list(void)
 }
 
 
-std::vector<std::vector<std::string>> ControlRom::get_samples_list(void)
+std::vector<std::vector<std::string>> ControlRom::get_samples_list(void) const
 {
   std::vector<std::vector<std::string>> samplesListVector;
 
@@ -727,7 +727,7 @@ std::vector<std::vector<std::string>> ControlRom::get_samples_list(void)
 }
 
 
-std::vector<std::vector<std::string>> ControlRom::get_variations_list(void)
+std::vector<std::vector<std::string>> ControlRom::get_variations_list(void) const
 {
   std::vector<std::vector<std::string>> varListVector;
 
@@ -748,7 +748,7 @@ std::vector<std::vector<std::string>> ControlRom::get_variations_list(void)
 }
 
 
-std::vector<std::string> ControlRom::get_drum_sets_list(void)
+std::vector<std::string> ControlRom::get_drum_sets_list(void) const
 {
   std::vector<std::string> drumSetsVector;
 
@@ -763,7 +763,7 @@ std::vector<std::string> ControlRom::get_drum_sets_list(void)
 }
 
 
-uint8_t ControlRom::lookup_table(uint8_t table, uint8_t index)
+uint8_t ControlRom::lookup_table(uint8_t table, uint8_t index) const
 {
   if (table >= _lookupTables.size() || index > 127)
     return 0;
@@ -772,7 +772,7 @@ uint8_t ControlRom::lookup_table(uint8_t table, uint8_t index)
 }
 
 
-float ControlRom::lookup_table(uint8_t table, float index, int interpolate)
+float ControlRom::lookup_table(uint8_t table, float index, int interpolate) const
 {
   if (table >= _lookupTables.size() || index > 127)
     return -1;
@@ -797,7 +797,7 @@ float ControlRom::lookup_table(uint8_t table, float index, int interpolate)
 }
 
 
-bool ControlRom::intro_anim_available(void)
+bool ControlRom::intro_anim_available(void) const
 {
   // TODO: Use SHA256 and proper ROM list to identify ROMs with intro animations
   if (_synthModel == sm_SC55mkII)
@@ -807,7 +807,7 @@ bool ControlRom::intro_anim_available(void)
 }
 
 
-std::vector<uint8_t> ControlRom::get_intro_anim(int animIndex)
+std::vector<uint8_t> ControlRom::get_intro_anim(int animIndex) const
 {
   int romIndex;
   int length;
@@ -146,37 +146,39 @@ public:
   // TODO: define constants for lookup table dimensions
   std::array<std::array<uint8_t, 128>, 19> _lookupTables;
   int _read_lookup_tables(std::ifstream &romFile);
-  uint8_t lookup_table(uint8_t table, uint8_t index);
-  float lookup_table(uint8_t table, float index, int interpolate = 1);
-
-  int dump_demo_songs(std::string path);
-  bool intro_anim_available(void);
-  std::vector<uint8_t> get_intro_anim(int animIndex = 0);
-
-  std::string model(void) { return _model; }
-  std::string version(void) { return _version; }
-  std::string date(void) { return _date; }
-  enum SynthGen generation(void) { return _synthGeneration; }
-
-  const std::vector<int>& drum_set_bank(void);
-  const uint8_t max_polyphony(void);
-
-  std::vector<std::vector<std::string>> get_instruments_list(void);
-  std::vector<std::vector<std::string>> get_partials_list(void);
-  std::vector<std::vector<std::string>> get_samples_list(void);
-  std::vector<std::vector<std::string>> get_variations_list(void);
-  std::vector<std::string> get_drum_sets_list(void);
-
-  inline struct Instrument& instrument(int i) { return _instruments[i]; }
-  inline struct Partial& partial(int p) { return _partials[p]; }
-  inline struct Sample& sample(int s) { return _samples[s]; }
-  inline struct DrumSet& drumSet(int ds) { return _drumSets[ds]; }
+  uint8_t lookup_table(uint8_t table, uint8_t index) const;
+  float lookup_table(uint8_t table, float index, int interpolate = 1) const;
+
+  int dump_demo_songs(std::string path) const;
+  bool intro_anim_available(void) const;
+  std::vector<uint8_t> get_intro_anim(int animIndex = 0) const;
+
+  // All data is read-only after the ROM has been loaded, so one ControlRom
+  // object can be shared by any number of Synth instances and threads.
+  std::string model(void) const { return _model; }
+  std::string version(void) const { return _version; }
+  std::string date(void) const { return _date; }
+  enum SynthGen generation(void) const { return _synthGeneration; }
+
+  const std::vector<int>& drum_set_bank(void) const;
+  const uint8_t max_polyphony(void) const;
+
+  std::vector<std::vector<std::string>> get_instruments_list(void) const;
+  std::vector<std::vector<std::string>> get_partials_list(void) const;
+  std::vector<std::vector<std::string>> get_samples_list(void) const;
+  std::vector<std::vector<std::string>> get_variations_list(void) const;
+  std::vector<std::string> get_drum_sets_list(void) const;
+
+  inline const struct Instrument& instrument(int i) const { return _instruments[i]; }
+  inline const struct Partial& partial(int p) const { return _partials[p]; }
+  inline const struct Sample& sample(int s) const { return _samples[s]; }
+  inline const struct DrumSet& drumSet(int ds) const { return _drumSets[ds]; }
   inline const std::array<uint16_t, 128>& variation(int v) const { return _variations[v]; }
 
-  inline int numSampleSets(void) { return _samples.size(); }
-  inline int numInstruments(void) { return _instruments.size(); }
+  inline int numSampleSets(void) const { return _samples.size(); }
+  inline int numInstruments(void) const { return _instruments.size(); }
 
-  inline std::vector<DrumSet> &get_drumsets_ref(void) { return _drumSets; }
+  inline const std::vector<DrumSet> &get_drumsets_ref(void) const { return _drumSets; }
 
 private:
   std::string _romPath;
@@ -210,14 +212,14 @@ private:
   static const std::vector<uint32_t> _banksSC88;
 
   int _identify_model(std::ifstream &romFile);
-  const std::vector<uint32_t> &_banks(void);
+  const std::vector<uint32_t> &_banks(void) const;
 
   // To be replaced with std::endian::native from C++20
-  inline bool _le_native(void) { uint16_t n = 1; return (*(uint8_t *) & n); } 
+  inline bool _le_native(void) const { uint16_t n = 1; return (*(uint8_t *) & n); } 
 
-  uint16_t _native_endian_uint16(uint8_t *ptr);
-  uint32_t _native_endian_3bytes_uint32(uint8_t *ptr);
-  uint32_t _native_endian_4bytes_uint32(uint8_t *ptr);
+  uint16_t _native_endian_uint16(uint8_t *ptr) const;
+  uint32_t _native_endian_3bytes_uint32(uint8_t *ptr) const;
+  uint32_t _native_endian_4bytes_uint32(uint8_t *ptr) const;
 
   int _read_instruments(std::ifstream &romFile);
   int _read_partials(std::ifstream &romFile);
@@ -0,0 +1,146 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "delay.h"
+
+#include <algorithm>
+
+
+namespace EmuSC {
+
+
+Delay::Delay(Settings *settings)
+  : _settings(settings),
+    _sampleRate(settings->get_param_uint32(SystemParam::SampleRate)),
+    _preLPF(0xff),
+    _lpFilter(_sampleRate),
+    _delayCenter(1),
+    _delayLeft(1),
+    _delayRight(1),
+    _levelCenter(0),
+    _levelLeft(0),
+    _levelRight(0),
+    _feedback(0),
+    _writeIndex(0)
+{
+  // Max delay time is 1 second, rounded up to a power of 2
+  uint32_t frames = 1;
+  while (frames <= _sampleRate)
+    frames <<= 1;
+
+  _delayLine.assign(frames, 0);
+  _delayLineMask = frames - 1;
+}
+
+
+Delay::~Delay()
+{}
+
+
+// Delay time table from the SC-88 owner's manual. Time is 0.1 ms - 1 s with
+// increasing step size.
+float Delay::_convert_time(uint8_t value)
+{
+  static const struct { uint8_t start; float time; float step; } ranges[] = {
+    { 0x01,   0.1,  0.1 },
+    { 0x14,   2.0,  0.2 },
+    { 0x23,   5.0,  0.5 },
+    { 0x2d,  10.0,  1.0 },
+    { 0x37,  20.0,  2.0 },
+    { 0x46,  50.0,  5.0 },
+    { 0x50, 100.0, 10.0 },
+    { 0x5a, 200.0, 20.0 },
+    { 0x69, 500.0, 50.0 } };
+
+  value = std::min(std::max(value, (uint8_t) 0x01), (uint8_t) 0x73);
+
+  int r = 8;
+  while (value < ranges[r].start)
+    r--;
+
+  return ranges[r].time + (value - ranges[r].start) * ranges[r].step;
+}
+
+
+uint32_t Delay::_time_to_frames(float ms)
+{
+  uint32_t frames = ms * 0.001 * _sampleRate;
+  return std::min(std::max(frames, (uint32_t) 1), _delayLineMask);
+}
+
+
+// Delay parameters are only read once per block
+void Delay::_update_params(void)
+{
+  float timeCenter =
+    _convert_time(_settings->get_param(PatchParam::DelayTimeCenter));
+  int ratioLeft = _settings->get_param(PatchParam::DelayTimeRatioLeft);
+  int ratioRight = _settings->get_param(PatchParam::DelayTimeRatioRight);
+
+  // Time ratios are 4% steps of the center delay time
+  _delayCenter = _time_to_frames(timeCenter);
+  _delayLeft = _time_to_frames(timeCenter * ratioLeft * 0.04);
+  _delayRight = _time_to_frames(timeCenter * ratioRight * 0.04);
+
+  _levelCenter = _settings->get_param(PatchParam::DelayLevelCenter) / 127.0;
+  _levelLeft = _settings->get_param(PatchParam::DelayLevelLeft) / 127.0;
+  _levelRight = _settings->get_param(PatchParam::DelayLevelRight) / 127.0;
+
+  // Negative feedback values inverts the phase
+  _feedback = (_settings->get_param(PatchParam::DelayFeedback) - 0x40) / 64.0;
+
+  uint8_t preLPF = _settings->get_param(PatchParam::DelayPreLPF) & 0x07;
+  if (preLPF != _preLPF) {
+    _preLPF = preLPF;
+    _lpFilter.calculate_coefficients(_lpCutoffFreq[_preLPF], 0.707);
+  }
+
+  _tail.set_length(EffectTail::feedback_length(_delayCenter, _feedback) +
+		   std::max(std::max(_delayCenter, _delayLeft), _delayRight));
+}
+
+
+bool Delay::process_block(const float *input, float *output, uint32_t frames)
+{
+  if (!_tail.update(input, frames))
+    return false;
+
+  _update_params();
+
+  float *line = _delayLine.data();
+  const uint32_t mask = _delayLineMask;
+
+  for (uint32_t i = 0; i < frames; i++) {
+    float center = line[(_writeIndex - _delayCenter) & mask];
+    float left = line[(_writeIndex - _delayLeft) & mask];
+    float right = line[(_writeIndex - _delayRight) & mask];
+
+    line[_writeIndex] = _lpFilter.apply(input[i]) + center * _feedback;
+
+    center *= _levelCenter;
+    output[i * 2] = center + left * _levelLeft;
+    output[i * 2 + 1] = center + right * _levelRight;
+
+    _writeIndex = (_writeIndex + 1) & mask;
+  }
+
+  return true;
+}
+
+}
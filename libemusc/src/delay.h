@@ -0,0 +1,87 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// SC-88 system delay effect. The delay line has three taps, center, left and
+// right, where left and right delay times are set as a ratio of the center
+// delay time. Feedback is taken from the center tap.
+
+
+#ifndef __DELAY_H__
+#define __DELAY_H__
+
+
+#include "effect_tail.h"
+#include "lowpass_filter.h"
+#include "settings.h"
+
+#include <array>
+#include <vector>
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+class Delay
+{
+ public:
+  Delay(Settings *settings);
+  ~Delay();
+
+  // Process a block of mono input and write interleaved stereo output.
+  // Returns false without writing any output if the effect is bypassed.
+  bool process_block(const float *input, float *output, uint32_t frames);
+
+
+ private:
+  Delay();
+
+  Settings *_settings;
+  uint32_t _sampleRate;
+
+  uint8_t _preLPF;
+  LowPassFilter _lpFilter;
+  EffectTail _tail;
+
+  // Delay for each tap in frames
+  uint32_t _delayCenter;
+  uint32_t _delayLeft;
+  uint32_t _delayRight;
+
+  float _levelCenter;
+  float _levelLeft;
+  float _levelRight;
+  float _feedback;
+
+  // Mono delay line. Size is a power of 2 so that positions wrap around
+  // with a mask.
+  std::vector<float> _delayLine;
+  uint32_t _delayLineMask;
+  uint32_t _writeIndex;
+
+  void _update_params(void);
+  uint32_t _time_to_frames(float ms);
+  static float _convert_time(uint8_t value);
+
+  std::array<int, 8> _lpCutoffFreq = { 8000, 5000, 3150, 2000,
+				       1250, 800, 400, 250 };
+};
+
+}
+
+#endif  // __DELAY_H__
@@ -0,0 +1,96 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Tail tracking for system effects. An effect is only processed while it has
+// input, and for the length of its tail after the input has become silent.
+// After that the output is known to be below -120 dB and the effect is
+// bypassed until new input arrives.
+
+
+#ifndef __EFFECT_TAIL_H__
+#define __EFFECT_TAIL_H__
+
+
+#include <algorithm>
+#include <cmath>
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+
+class EffectTail
+{
+public:
+  EffectTail()
+    : _length(0),
+      _silentFrames(0),
+      _active(false)
+  {}
+
+  // Returns true if the effect must be processed for this block of input
+  inline bool update(const float *input, uint32_t frames)
+  {
+    float peak = 0;
+    for (uint32_t i = 0; i < frames; i++)
+      peak = std::max(peak, std::fabs(input[i]));
+
+    if (peak > silence) {
+      _silentFrames = 0;
+      _active = true;
+      return true;
+    }
+
+    if (!_active)
+      return false;
+
+    _silentFrames += frames;
+    if (_silentFrames > _length)
+      _active = false;
+
+    return true;
+  }
+
+  // Tail length in frames after the last non-silent input
+  inline void set_length(double frames)
+  { _length = (uint32_t) std::min(frames, 4294967295.0); }
+
+  // Tail length of a delay line with feedback. Number of passes needed for
+  // the feedback to decay to -120 dB, times the delay length.
+  static double feedback_length(double delay, float feedback)
+  {
+    feedback = std::fabs(feedback);
+    if (feedback < silence)
+      return delay;
+
+    return delay * (1 + -6 / std::log10(std::min(feedback, 0.9999f)));
+  }
+
+  // -120 dB relative to internal full scale (0.5)
+  static constexpr float silence = 0.5e-6;
+
+private:
+  uint32_t _length;
+  uint32_t _silentFrames;
+  bool _active;
+};
+
+}
+
+#endif  // __EFFECT_TAIL_H__
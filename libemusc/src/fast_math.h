@@ -0,0 +1,108 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Fast float approximations of exp2, log2 and related conversions used for
+// pitch, volume, envelope and filter cutoff calculations.
+//
+// exp2: The exponent is split into an integer part, put directly into the
+// float exponent bits, and a fraction in [-0.5, 0.5] evaluated with a 6th
+// order polynomial. Max relative error is 2.5e-7 for x in [-126, 127], and x
+// is clamped to this range.
+//
+// log2: The mantissa m is scaled to [0.71, 1.41] and log2(m) is found from
+// the atanh series in t = (m - 1) / (m + 1) up to t^7. Max absolute error is
+// 1.6e-7 plus rounding of the result to float, i.e. 4e-6 for the largest
+// exponents. Only valid for normal positive x.
+
+
+#ifndef __FAST_MATH_H__
+#define __FAST_MATH_H__
+
+
+#include <cstring>
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+namespace FastMath {
+
+
+inline float exp2(float x)
+{
+  if (x < -126) x = -126;
+  else if (x > 127) x = 127;
+
+  float r = x + 0.5f;
+  int32_t n = (int32_t) r;
+  n -= (r < n);                                          // floor(x + 0.5)
+
+  float y = (x - n) * 0.69314718f;                       // ln(2)
+  float p = 1 + y * (1 + y * (1 / 2.0f + y * (1 / 6.0f + y * (1 / 24.0f +
+					  y * (1 / 120.0f + y / 720.0f)))));
+
+  int32_t bits = (n + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+
+  return p * scale;
+}
+
+
+inline float log2(float x)
+{
+  int32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+
+  int32_t e = ((bits >> 23) & 0xff) - 127;
+  bits = (bits & 0x007fffff) | 0x3f800000;               // Mantissa in [1, 2)
+
+  float m;
+  std::memcpy(&m, &bits, sizeof(m));
+  if (m > 1.41421356f) {
+    m *= 0.5f;
+    e++;
+  }
+
+  float t = (m - 1) / (m + 1);
+  float t2 = t * t;
+
+  return e + t * (2.88539008f + t2 * (0.96179669f + t2 * (0.57707802f +
+							   t2 * 0.41219858f)));
+}
+
+
+// e^x
+inline float exp(float x)
+{
+  return exp2(x * 1.44269504f);                          // log2(e)
+}
+
+
+// Decibel to linear amplitude
+inline float db_to_linear(float dB)
+{
+  return exp2(dB * 0.16609640f);                         // log2(10) / 20
+}
+
+}
+
+}
+
+#endif  // __FAST_MATH_H__
@@ -0,0 +1,74 @@
+/*  
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Storage for an optional object that is constructed in place inside its
+// owner instead of on the heap. Used for all voice state so that note on and
+// note off on the audio thread never allocates or frees memory.
+
+
+#ifndef __IN_PLACE_H__
+#define __IN_PLACE_H__
+
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <stddef.h>
+
+
+namespace EmuSC {
+
+template <class T>
+class InPlace
+{
+public:
+  InPlace() : _ptr(NULL) {}
+  ~InPlace() { destroy(); }
+
+  template <class... Args>
+  T *create(Args&&... args)
+  {
+    destroy();
+    _ptr = new (&_storage) T(std::forward<Args>(args)...);
+    return _ptr;
+  }
+
+  void destroy(void)
+  {
+    if (_ptr) {
+      _ptr->~T();
+      _ptr = NULL;
+    }
+  }
+
+  inline T *get(void) { return _ptr; }
+  inline T *operator->(void) { return _ptr; }
+  inline explicit operator bool(void) const { return _ptr != NULL; }
+
+private:
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type _storage;
+  T *_ptr;
+
+  InPlace(const InPlace &);
+  InPlace &operator=(const InPlace &);
+};
+
+}
+
+#endif  // __IN_PLACE_H__
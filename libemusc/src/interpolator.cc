@@ -0,0 +1,272 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The SIMD versions process 4 (SSE2) or 8 (AVX2) frames at a time and leave
+// any remaining frames to the scalar versions. Since there is no gather in
+// SSE2 the sample reads are done one by one, but index clamping and the
+// interpolation itself is vectorized. AVX2 is selected at runtime on GCC and
+// Clang, so the library does not need to be built for a specific CPU.
+
+
+#include "interpolator.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EMUSC_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(EMUSC_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define EMUSC_AVX2
+#include <immintrin.h>
+#endif
+
+
+namespace EmuSC {
+
+
+#ifdef EMUSC_SSE2
+
+// Load the 4 samples at integer positions p + offset, clamped to [0, last]
+static inline __m128 _load_sse2(const float *pcm, __m128 p, __m128 offset,
+				__m128 last)
+{
+  __m128 c = _mm_min_ps(_mm_max_ps(_mm_add_ps(p, offset), _mm_setzero_ps()),
+			last);
+  alignas(16) int32_t idx[4];
+  _mm_store_si128((__m128i *) idx, _mm_cvttps_epi32(c));
+
+  return _mm_setr_ps(pcm[idx[0]], pcm[idx[1]], pcm[idx[2]], pcm[idx[3]]);
+}
+
+
+static uint32_t _linear_sse2(const float *pcm, int32_t last,
+			     const int32_t *pos, const float *frac, float *out,
+			     uint32_t frames)
+{
+  const __m128 l = _mm_set1_ps((float) last);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1);
+
+  uint32_t i;
+  for (i = 0; i + 4 <= frames; i += 4) {
+    __m128 p = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &pos[i]));
+    __m128 t = _mm_loadu_ps(&frac[i]);
+
+    __m128 y1 = _load_sse2(pcm, p, zero, l);
+    __m128 y2 = _load_sse2(pcm, p, one, l);
+
+    _mm_storeu_ps(&out[i], _mm_add_ps(y1, _mm_mul_ps(t, _mm_sub_ps(y2, y1))));
+  }
+
+  return i;
+}
+
+
+static uint32_t _cubic_sse2(const float *pcm, int32_t last,
+			    const int32_t *pos, const float *frac, float *out,
+			    uint32_t frames)
+{
+  const __m128 l = _mm_set1_ps((float) last);
+  const __m128 m1 = _mm_set1_ps(-1);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1);
+  const __m128 two = _mm_set1_ps(2);
+  const __m128 half = _mm_set1_ps(0.5);
+  const __m128 oneHalf = _mm_set1_ps(1.5);
+  const __m128 twoHalf = _mm_set1_ps(2.5);
+
+  uint32_t i;
+  for (i = 0; i + 4 <= frames; i += 4) {
+    __m128 p = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &pos[i]));
+    __m128 t = _mm_loadu_ps(&frac[i]);
+
+    __m128 y0 = _load_sse2(pcm, p, m1, l);
+    __m128 y1 = _load_sse2(pcm, p, zero, l);
+    __m128 y2 = _load_sse2(pcm, p, one, l);
+    __m128 y3 = _load_sse2(pcm, p, two, l);
+
+    __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(y2, y0));
+    __m128 c2 = _mm_sub_ps(_mm_add_ps(y0, _mm_mul_ps(two, y2)),
+			   _mm_add_ps(_mm_mul_ps(twoHalf, y1),
+				      _mm_mul_ps(half, y3)));
+    __m128 c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(y3, y0)),
+			   _mm_mul_ps(oneHalf, _mm_sub_ps(y1, y2)));
+
+    __m128 r = _mm_add_ps(_mm_mul_ps(c3, t), c2);
+    r = _mm_add_ps(_mm_mul_ps(r, t), c1);
+    r = _mm_add_ps(_mm_mul_ps(r, t), y1);
+
+    _mm_storeu_ps(&out[i], r);
+  }
+
+  return i;
+}
+
+#endif  // EMUSC_SSE2
+
+
+#ifdef EMUSC_AVX2
+
+// Gather the 8 samples at integer positions p + offset, clamped to [0, last]
+__attribute__((target("avx2")))
+static inline __m256 _load_avx2(const float *pcm, __m256i p, int offset,
+				__m256i last)
+{
+  __m256i c = _mm256_add_epi32(p, _mm256_set1_epi32(offset));
+  c = _mm256_min_epi32(_mm256_max_epi32(c, _mm256_setzero_si256()), last);
+
+  return _mm256_i32gather_ps(pcm, c, 4);
+}
+
+
+__attribute__((target("avx2")))
+static uint32_t _linear_avx2(const float *pcm, int32_t last,
+			     const int32_t *pos, const float *frac, float *out,
+			     uint32_t frames)
+{
+  const __m256i l = _mm256_set1_epi32(last);
+
+  uint32_t i;
+  for (i = 0; i + 8 <= frames; i += 8) {
+    __m256i p = _mm256_loadu_si256((const __m256i *) &pos[i]);
+    __m256 t = _mm256_loadu_ps(&frac[i]);
+
+    __m256 y1 = _load_avx2(pcm, p, 0, l);
+    __m256 y2 = _load_avx2(pcm, p, 1, l);
+
+    _mm256_storeu_ps(&out[i],
+		     _mm256_add_ps(y1, _mm256_mul_ps(t, _mm256_sub_ps(y2, y1))));
+  }
+
+  return i;
+}
+
+
+__attribute__((target("avx2")))
+static uint32_t _cubic_avx2(const float *pcm, int32_t last,
+			    const int32_t *pos, const float *frac, float *out,
+			    uint32_t frames)
+{
+  const __m256i l = _mm256_set1_epi32(last);
+  const __m256 two = _mm256_set1_ps(2);
+  const __m256 half = _mm256_set1_ps(0.5);
+  const __m256 oneHalf = _mm256_set1_ps(1.5);
+  const __m256 twoHalf = _mm256_set1_ps(2.5);
+
+  uint32_t i;
+  for (i = 0; i + 8 <= frames; i += 8) {
+    __m256i p = _mm256_loadu_si256((const __m256i *) &pos[i]);
+    __m256 t = _mm256_loadu_ps(&frac[i]);
+
+    __m256 y0 = _load_avx2(pcm, p, -1, l);
+    __m256 y1 = _load_avx2(pcm, p, 0, l);
+    __m256 y2 = _load_avx2(pcm, p, 1, l);
+    __m256 y3 = _load_avx2(pcm, p, 2, l);
+
+    __m256 c1 = _mm256_mul_ps(half, _mm256_sub_ps(y2, y0));
+    __m256 c2 = _mm256_sub_ps(_mm256_add_ps(y0, _mm256_mul_ps(two, y2)),
+			      _mm256_add_ps(_mm256_mul_ps(twoHalf, y1),
+					    _mm256_mul_ps(half, y3)));
+    __m256 c3 = _mm256_add_ps(_mm256_mul_ps(half, _mm256_sub_ps(y3, y0)),
+			      _mm256_mul_ps(oneHalf, _mm256_sub_ps(y1, y2)));
+
+    __m256 r = _mm256_add_ps(_mm256_mul_ps(c3, t), c2);
+    r = _mm256_add_ps(_mm256_mul_ps(r, t), c1);
+    r = _mm256_add_ps(_mm256_mul_ps(r, t), y1);
+
+    _mm256_storeu_ps(&out[i], r);
+  }
+
+  return i;
+}
+
+
+static bool _has_avx2(void)
+{
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+}
+
+#endif  // EMUSC_AVX2
+
+
+void Interpolator::process(enum Mode mode, const float *pcm, int32_t last,
+			   const int32_t *pos, const float *frac, float *out,
+			   uint32_t frames)
+{
+  uint32_t done = 0;
+
+  if (mode == Mode::Linear) {
+#if defined(EMUSC_AVX2)
+    if (_has_avx2())
+      done = _linear_avx2(pcm, last, pos, frac, out, frames);
+#endif
+#if defined(EMUSC_SSE2)
+    done += _linear_sse2(pcm, last, pos + done, frac + done, out + done,
+			 frames - done);
+#endif
+    _linear(pcm, last, pos + done, frac + done, out + done, frames - done);
+
+  } else {
+#if defined(EMUSC_AVX2)
+    if (_has_avx2())
+      done = _cubic_avx2(pcm, last, pos, frac, out, frames);
+#endif
+#if defined(EMUSC_SSE2)
+    done += _cubic_sse2(pcm, last, pos + done, frac + done, out + done,
+			frames - done);
+#endif
+    _cubic(pcm, last, pos + done, frac + done, out + done, frames - done);
+  }
+}
+
+
+void Interpolator::_linear(const float *pcm, int32_t last, const int32_t *pos,
+			   const float *frac, float *out, uint32_t frames)
+{
+  for (uint32_t i = 0; i < frames; i++) {
+    float y1 = pcm[std::min(std::max(pos[i], 0), last)];
+    float y2 = pcm[std::min(std::max(pos[i] + 1, 0), last)];
+
+    out[i] = y1 + frac[i] * (y2 - y1);
+  }
+}
+
+
+void Interpolator::_cubic(const float *pcm, int32_t last, const int32_t *pos,
+			  const float *frac, float *out, uint32_t frames)
+{
+  for (uint32_t i = 0; i < frames; i++) {
+    float y0 = pcm[std::min(std::max(pos[i] - 1, 0), last)];
+    float y1 = pcm[std::min(std::max(pos[i], 0), last)];
+    float y2 = pcm[std::min(std::max(pos[i] + 1, 0), last)];
+    float y3 = pcm[std::min(std::max(pos[i] + 2, 0), last)];
+    float t = frac[i];
+
+    float c1 = 0.5f * (y2 - y0);
+    float c2 = (y0 + 2 * y2) - (2.5f * y1 + 0.5f * y3);
+    float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+
+    out[i] = ((c3 * t + c2) * t + c1) * t + y1;
+  }
+}
+
+}
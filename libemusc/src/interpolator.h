@@ -0,0 +1,60 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Sample interpolation kernels for PCM playback. Each call produces one output
+// sample per frame from the integer sample positions in pos[] and the
+// fractional parts in frac[]. Neighbour samples outside [0, last] are clamped
+// to the nearest valid sample, so no bounds checks are needed by the caller.
+// SSE2 and AVX2 versions are used when supported by the compiler and CPU,
+// with plain C++ as fallback.
+
+
+#ifndef __INTERPOLATOR_H__
+#define __INTERPOLATOR_H__
+
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+
+class Interpolator
+{
+public:
+  enum class Mode {
+    Linear,                   // 2 point linear. Default
+    Cubic                     // 4 point, 3rd order Hermite (Catmull-Rom)
+  };
+
+  static void process(enum Mode mode, const float *pcm, int32_t last,
+		      const int32_t *pos, const float *frac, float *out,
+		      uint32_t frames);
+
+private:
+  static void _linear(const float *pcm, int32_t last, const int32_t *pos,
+		      const float *frac, float *out, uint32_t frames);
+  static void _cubic(const float *pcm, int32_t last, const int32_t *pos,
+		     const float *frac, float *out, uint32_t frames);
+
+  Interpolator();
+};
+
+}
+
+#endif  // __INTERPOLATOR_H__
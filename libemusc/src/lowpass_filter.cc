@@ -32,7 +32,8 @@ namespace EmuSC {
 
 
 LowPassFilter::LowPassFilter(int sampleRate)
-  : _sampleRate(sampleRate)
+  : _sampleRate(sampleRate),
+    _t(1.0 / sampleRate)
 {}
 
 
@@ -46,15 +47,16 @@ void LowPassFilter::calculate_coefficients(float frequency, float q)
 {
   float w = frequency * 2.0 * M_PI;
   float t = 1.0 / _sampleRate;
+  double wt2 = (double) w * w * t * t;
 
   // Calculate coefficients (redo if sampleRate, frequency or q changes)
-  _d[0] = 4.0 + ((w / q)* 2.0 * t) + pow(w, 2.0) * pow(t, 2.0);
-  _d[1] = ((2.0 * pow(t, 2.0) * pow(w, 2.0)) -8.0) / _d[0];
-  _d[2] = (4.0 - (w / q * 2.0 * t) + (pow(w, 2.0) * pow(t, 2.0))) / _d[0];
+  _d[0] = 4.0 + ((w / q)* 2.0 * t) + wt2;
+  _d[1] = ((2.0 * wt2) -8.0) / _d[0];
+  _d[2] = (4.0 - (w / q * 2.0 * t) + wt2) / _d[0];
 
-  _n[0] = pow(w, 2.0) * pow(t, 2.0) / _d[0];
-  _n[1] = pow(w, 2.0) * 2.0 * pow(t, 2.0) / _d[0];
-  _n[2] = pow(w, 2.0) * pow(t, 2.0) / _d[0];
+  _n[0] = wt2 / _d[0];
+  _n[1] = wt2 * 2.0 / _d[0];
+  _n[2] = wt2 / _d[0];
 }
 
 }
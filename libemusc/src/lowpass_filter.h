@@ -36,8 +36,26 @@ public:
 
   void calculate_coefficients(float frequency, float q);
 
+  // Same as above for per frame cutoff changes, with angular frequency w and
+  // 1 / q precalculated. Coefficients use a single division.
+  inline void update_coefficients(float w, float invQ)
+  {
+    float wt = w * _t;
+    float wt2 = wt * wt;
+    float a = 2 * wt * invQ;
+    float d0 = 1 / (4 + a + wt2);
+
+    _d[1] = (2 * wt2 - 8) * d0;
+    _d[2] = (4 - a + wt2) * d0;
+
+    _n[0] = wt2 * d0;
+    _n[1] = 2 * _n[0];
+    _n[2] = _n[0];
+  }
+
 private:
   int _sampleRate;
+  float _t;                   // 1 / sample rate
   
   LowPassFilter();
 };
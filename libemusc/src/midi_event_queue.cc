@@ -0,0 +1,113 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The queue is a bounded MPMC ring buffer as described by Dmitry Vyukov, but
+// with a plain consumer index since there is only one reader. Each cell has a
+// sequence number telling whether it is ready for writing (sequence == pos)
+// or reading (sequence == pos + 1).
+
+
+#include "midi_event_queue.h"
+
+#include <cstring>
+
+
+namespace EmuSC {
+
+
+MidiEventQueue::MidiEventQueue(uint32_t size)
+  : _enqueuePos(0),
+    _dequeuePos(0)
+{
+  size_t s = 2;
+  while (s < size)
+    s <<= 1;
+
+  _buffer = new Cell[s];
+  _mask = s - 1;
+
+  for (size_t i = 0; i < s; i++)
+    _buffer[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+
+MidiEventQueue::~MidiEventQueue()
+{
+  delete[] _buffer;
+}
+
+
+bool MidiEventQueue::push(const uint8_t *data, uint16_t length,
+			  uint64_t timestamp)
+{
+  if (length > maxEventSize)
+    return false;
+
+  Cell *cell;
+  size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+
+  // Claim a free cell by moving the enqueue position forward
+  while (1) {
+    cell = &_buffer[pos & _mask];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+    if (diff == 0) {
+      if (_enqueuePos.compare_exchange_weak(pos, pos + 1,
+					    std::memory_order_relaxed))
+	break;
+    } else if (diff < 0) {
+      return false;                                            // Queue is full
+    } else {
+      pos = _enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->event.timestamp = timestamp;
+  cell->event.length = length;
+  std::memcpy(cell->event.data, data, length);
+
+  // Publish event to consumer
+  cell->sequence.store(pos + 1, std::memory_order_release);
+
+  return true;
+}
+
+
+MidiEventQueue::Event *MidiEventQueue::front(void)
+{
+  Cell *cell = &_buffer[_dequeuePos & _mask];
+  size_t seq = cell->sequence.load(std::memory_order_acquire);
+
+  if (seq != _dequeuePos + 1)
+    return NULL;
+
+  return &cell->event;
+}
+
+
+void MidiEventQueue::pop(void)
+{
+  Cell *cell = &_buffer[_dequeuePos & _mask];
+
+  // Release cell to producers for the next round
+  cell->sequence.store(_dequeuePos + _mask + 1, std::memory_order_release);
+  _dequeuePos++;
+}
+
+}
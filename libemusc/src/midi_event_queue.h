@@ -0,0 +1,81 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Bounded lock-free queue for timestamped MIDI events. Any number of threads
+// may push events (MIDI input, user interface), while only the audio render
+// thread is allowed to read them. Neither side ever blocks; pushing to a full
+// queue fails and the event is dropped.
+
+
+#ifndef __MIDI_EVENT_QUEUE_H__
+#define __MIDI_EVENT_QUEUE_H__
+
+
+#include <atomic>
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+
+class MidiEventQueue
+{
+public:
+  // Largest supported event, including SysEx start and end bytes. This is
+  // the longest Roland DT1 message applied by Synth: 5 header bytes, 3
+  // address bytes, 16 data bytes, checksum and end byte.
+  static const uint16_t maxEventSize = 26;
+
+  struct Event {
+    uint64_t timestamp;                  // Frame number, 0 = next block
+    uint16_t length;
+    uint8_t data[maxEventSize];
+  };
+
+  MidiEventQueue(uint32_t size = 1024);  // Size is rounded up to power of 2
+  ~MidiEventQueue();
+
+  // Producer side, safe to call from any thread
+  bool push(const uint8_t *data, uint16_t length, uint64_t timestamp);
+
+  // Consumer side, audio render thread only. front() returns NULL if empty.
+  Event *front(void);
+  void pop(void);
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    Event event;
+  };
+
+  Cell *_buffer;
+  size_t _mask;
+
+  // Keep producer and consumer positions on separate cache lines
+  char _pad0[64];
+  std::atomic<size_t> _enqueuePos;
+  char _pad1[64];
+  size_t _dequeuePos;
+  char _pad2[64];
+};
+
+}
+
+#endif  // __MIDI_EVENT_QUEUE_H__
@@ -24,17 +24,21 @@
 namespace EmuSC {
 
 
-Note::Note(uint8_t key, uint8_t velocity, ControlRom &ctrlRom, PcmRom &pcmRom,
-	   Settings *settings, int8_t partId)
+Note::Note(uint8_t key, uint8_t velocity, const ControlRom &ctrlRom,
+	   const PcmRom &pcmRom, Settings *settings, int8_t partId,
+	   VoiceTable *voices, uint32_t firstVoice)
   : _key(key),
     _velocity(velocity),
     _settings(settings),
     _partId(partId),
     _sustain(false),
     _stopped(false),
+    _released(false),
+    _serial(0),
+    _nextOnKey(NULL),
     _7bScale(1/127.0)
 {
-  _partial[0] = _partial[1] = NULL;
+  _LFO[0] = _LFO[1] = NULL;
 
   // 1. Find correct instrument index for note
   // Note: toneBank is used as drumSet index for rhythm parts
@@ -51,9 +55,13 @@ Note::Note(uint8_t key, uint8_t velocity, ControlRom &ctrlRom, PcmRom &pcmRom,
 
   // 2. Setup LFOs
   int sampleRate = settings->get_param_uint32(SystemParam::SampleRate);
-  _LFO[0] = new WaveGenerator(WaveGenerator::Waveform::sine, sampleRate,
-			      ctrlRom.instrument(instrumentIndex).LFO1Rate);
-  _LFO[1] = new WaveGenerator(WaveGenerator::Waveform::sine, sampleRate);
+  _LFO[0] = _LFOData[0].create(WaveGenerator::Waveform::sine, sampleRate,
+				ctrlRom.instrument(instrumentIndex).LFO1Rate);
+  _LFO[1] = _LFOData[1].create(WaveGenerator::Waveform::sine, sampleRate);
+
+  uint8_t controlPeriod = settings->get_param(SystemParam::ControlPeriod);
+  _LFO[0]->set_control_period(controlPeriod);
+  _LFO[1]->set_control_period(controlPeriod);
 
   // LFO delay and fade time are set only upon note start
   _LFO[0]->set_delay(ctrlRom.instrument(instrumentIndex).LFO1Delay +
@@ -67,19 +75,18 @@ Note::Note(uint8_t key, uint8_t velocity, ControlRom &ctrlRom, PcmRom &pcmRom,
     if (pIndex == 0xffff)        // Partial 1 always used, but not 2. partial
       break;
 
-    _partial[i] = new Partial(key, i, instrumentIndex, ctrlRom, pcmRom, _LFO,
-			      settings, partId);
+    _partial[i].create(key, i, instrumentIndex, ctrlRom, pcmRom, _LFO, settings,
+		       partId, voices, firstVoice + i);
+    voices->set_velocity(firstVoice + i, velocity * _7bScale);
   }
 }
 
 
 Note::~Note()
 {
-  delete _partial[0];
-  delete _partial[1];
-
-  delete _LFO[0];
-  delete _LFO[1];
+  // Partials refer to the LFOs and must be destroyed first
+  _partial[0].destroy();
+  _partial[1].destroy();
 }
 
 
@@ -94,6 +101,8 @@ void Note::stop(void)
 
     if (_partial[1])
       _partial[1]->stop();
+
+    _released = true;
   }
 }
 
@@ -109,6 +118,8 @@ void Note::stop(uint8_t key)
 
     if (_partial[1])
       _partial[1]->stop();
+
+    _released = true;
   }
 }
 
@@ -122,46 +133,61 @@ void Note::sustain(bool state)
 }
 
 
-bool Note::get_next_sample(float *partSample)
+// Step both LFOs and update the control values of both partials for a block
+int Note::update(uint32_t frames, uint32_t *voices)
 {
-  bool finished[2] = {0, 0};
+  // Notes without a valid instrument has no partials
+  if (!_partial[0] && !_partial[1])
+    return 0;
 
-  // Iterate both LFOs
   _LFO[0]->update_frequency(_settings->get_param(PatchParam::Acc_LFO1RateControl,
 						_partId) - 0x40 +
 			   _settings->get_param(PatchParam::VibratoRate,
 						_partId) - 0x40);
   _LFO[1]->update_frequency(_settings->get_param(PatchParam::Acc_LFO2RateControl,
 						_partId) - 0x40);
-  _LFO[0]->next();
-  _LFO[1]->next();
-
-  // Temporary samples for LEFT and RIGHT channel
-  float sample[2] = {0, 0};
+  _LFO[0]->next_block(frames);
+  _LFO[1]->next_block(frames);
 
-  // Iterate both partials
+  int numVoices = 0;
   for (int p = 0; p < 2; p ++) {
-
-    // Skip this iteration if the partial in not used
-    if  (_partial[p] == NULL) {
-      finished[p] = 1;
-      continue;
+    if (_partial[p]) {
+      _partial[p]->update(frames);
+      voices[numVoices++] = _partial[p]->voice();
     }
-
-    finished[p] = _partial[p]->get_next_sample(sample);
   }
 
-  if (finished[0] == true && finished[1] == true)
-    return 1;
+  return numVoices;
+}
+
 
-  // Apply key velocity
-  sample[0] *= _velocity * _7bScale;
-  sample[1] *= _velocity * _7bScale;
+void Note::filter(void)
+{
+  for (int p = 0; p < 2; p ++)
+    if (_partial[p])
+      _partial[p]->filter();
+}
+
+
+// Returns true when both partials have finished
+bool Note::finished(void)
+{
+  for (int p = 0; p < 2; p ++)
+    if (_partial[p] && !_partial[p]->finished())
+      return 0;
 
-  partSample[0] += sample[0];
-  partSample[1] += sample[1];
+  return 1;
+}
+
+
+float Note::level(void)
+{
+  float level = 0;
+  for (int i = 0; i < 2; i++)
+    if (_partial[i] && _partial[i]->level() > level)
+      level = _partial[i]->level();
 
-  return 0;
+  return level;
 }
 
 
@@ -22,9 +22,11 @@
 
 
 #include "control_rom.h"
+#include "in_place.h"
 #include "pcm_rom.h"
 #include "partial.h"
 #include "settings.h"
+#include "voice_table.h"
 #include "wave_generator.h"
 
 #include <stdint.h>
@@ -37,29 +39,55 @@ namespace EmuSC {
 class Note
 {
 public:
-  Note(uint8_t key, uint8_t velocity, ControlRom &ctrlRom, PcmRom &pcmRom,
-       Settings *settings, int8_t partId);
+  Note(uint8_t key, uint8_t velocity, const ControlRom &ctrlRom,
+       const PcmRom &pcmRom, Settings *settings, int8_t partId,
+       VoiceTable *voices, uint32_t firstVoice);
   ~Note();
 
   void stop(void);
   void stop(uint8_t key);
   void sustain(bool state);
 
-  bool get_next_sample(float *sampleOut);
+  // Block rendering stages, see Partial. update() writes the voice table
+  // indexes of the note's partials to voices and returns their number.
+  int update(uint32_t frames, uint32_t *voices);
+  void filter(void);
+  bool finished(void);
+
   int get_num_partials(void);
 
+  // Note on order, used for selecting notes to steal at voice limit
+  uint64_t serial(void) { return _serial; }
+  void set_serial(uint64_t serial) { _serial = serial; }
+
+  bool released(void) { return _released; }
+
+  // Level of the loudest partial, used for selecting notes to steal
+  float level(void);
+
+  uint8_t key(void) { return _key; }
+
+  // Chain of notes with the same key, used by the part key index
+  Note *next_on_key(void) { return _nextOnKey; }
+  void set_next_on_key(Note *note) { _nextOnKey = note; }
+
 private:
   uint8_t _key;
   uint8_t _velocity;
 
   bool _sustain;
   bool _stopped;
+  bool _released;            // Partials have received note off
+
+  uint64_t _serial;
+  Note *_nextOnKey;
 
   const double _7bScale;     // Constant: 1 / 127
 
+  InPlace<WaveGenerator> _LFOData[2];
   WaveGenerator *_LFO[2];
 
-  struct Partial *_partial[2];
+  InPlace<Partial> _partial[2];
 
   Settings *_settings;
   int8_t _partId;
@@ -0,0 +1,91 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "note_pool.h"
+
+#include <new>
+
+
+namespace EmuSC {
+
+
+NotePool::NotePool(uint32_t size)
+  : _slots(new Slot[size]),
+    _size(size),
+    _voices(size * 2),
+    _partialsUsed(0),
+    _nextSerial(0),
+    _notesDropped(0)
+{
+  _lock.clear();
+
+  // Hand out the lowest slots first
+  _freeList.reserve(size);
+  for (uint32_t i = size; i > 0; i--)
+    _freeList.push_back(i - 1);
+}
+
+
+// All notes must be returned to the pool before it is deleted
+NotePool::~NotePool()
+{
+  delete[] _slots;
+}
+
+
+Note *NotePool::new_note(uint8_t key, uint8_t velocity,
+			 const ControlRom &ctrlRom, const PcmRom &pcmRom,
+			 Settings *settings, int8_t partId)
+{
+  _acquire();
+  if (_freeList.empty()) {
+    _release();
+    return NULL;
+  }
+
+  uint32_t index = _freeList.back();
+  _freeList.pop_back();
+  uint64_t serial = _nextSerial++;
+  _release();
+
+  Note *note = new (&_slots[index]) Note(key, velocity, ctrlRom, pcmRom,
+					 settings, partId, &_voices, index * 2);
+  note->set_serial(serial);
+  _partialsUsed += note->get_num_partials();
+
+  return note;
+}
+
+
+void NotePool::delete_note(Note *note)
+{
+  if (!note)
+    return;
+
+  _partialsUsed -= note->get_num_partials();
+  note->~Note();
+
+  uint32_t index = (Slot *) note - _slots;
+
+  _acquire();
+  _freeList.push_back(index);
+  _release();
+}
+
+}
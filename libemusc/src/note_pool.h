@@ -0,0 +1,98 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Fixed size pool of preallocated notes. All voice state lives inside the
+// Note objects and the voice table, so starting and ending notes never
+// touches the heap. Each note slot owns two voices in the voice table, one
+// for each partial. Notes are returned to the pool from the part render
+// jobs, which may run in parallel, so the free list is protected by a small
+// spinlock.
+
+
+#ifndef __NOTE_POOL_H__
+#define __NOTE_POOL_H__
+
+
+#include "control_rom.h"
+#include "note.h"
+#include "pcm_rom.h"
+#include "settings.h"
+#include "voice_table.h"
+
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+
+class NotePool
+{
+public:
+  NotePool(uint32_t size);
+  ~NotePool();
+
+  // Returns NULL if all notes are in use
+  Note *new_note(uint8_t key, uint8_t velocity, const ControlRom &ctrlRom,
+		 const PcmRom &pcmRom, Settings *settings, int8_t partId);
+  void delete_note(Note *note);
+
+  uint32_t size(void) { return _size; }
+  VoiceTable *voices(void) { return &_voices; }
+
+  // Number of partials in use by all notes, kept up to date by new_note()
+  // and delete_note()
+  int partials_used(void) { return _partialsUsed.load(std::memory_order_relaxed); }
+
+  // Serial number that will be given to the next new note
+  uint64_t next_serial(void) { return _nextSerial; }
+
+  // Number of note on events ignored due to the voice limit
+  void count_dropped(void)
+  { _notesDropped.fetch_add(1, std::memory_order_relaxed); }
+  uint32_t notes_dropped(void)
+  { return _notesDropped.load(std::memory_order_relaxed); }
+
+private:
+  typedef std::aligned_storage<sizeof(Note), alignof(Note)>::type Slot;
+
+  Slot *_slots;
+  uint32_t _size;
+
+  VoiceTable _voices;
+
+  std::vector<uint32_t> _freeList;     // Stack of unused slot indexes
+  std::atomic_flag _lock;
+
+  std::atomic<int> _partialsUsed;
+  uint64_t _nextSerial;
+  std::atomic<uint32_t> _notesDropped;
+
+  inline void _acquire(void)
+  { while (_lock.test_and_set(std::memory_order_acquire)); }
+  inline void _release(void) { _lock.clear(std::memory_order_release); }
+
+  NotePool();
+};
+
+}
+
+#endif  // __NOTE_POOL_H__
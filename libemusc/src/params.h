@@ -42,6 +42,8 @@ enum class SystemParam : int {
   // Part 2: Settings outside SysEx chart
   SampleRate          = 0x0080,    // 4B: [32000 - 96000 : 44100]
   Channels            = 0x0084,    // [1 - 2 : 2]
+  ControlPeriod       = 0x0085,    // [1 - 64 : 16] Frames per LFO/env. update
+  Interpolation       = 0x0086,    // [0 - 1 : 0] 0 = linear, 1 = cubic
 
   RxSysEx             = 0x0090,    // [0 - 1 : 1]
   RxGMOn              = 0x0091,    // [0 - 1 : 1]
@@ -78,6 +80,19 @@ enum class PatchParam : int {
   ChorusRate          = 0x013d,    // [0x00 - 0x7f : 0x03]
   ChorusDepth         = 0x013e,    // [0x00 - 0x7f : 0x13]
   ChorusSendToReverb  = 0x013f,    // [0x00 - 0x7f : 0x00]
+  ChorusSendToDelay   = 0x0140,    // SC-88 [0x00 - 0x7f : 0x00]
+
+  DelayMacro          = 0x0150,    // SC-88 [0x00 - 0x09 : 0x00]
+  DelayPreLPF         = 0x0151,    // SC-88 [0x00 - 0x07 : 0x00]
+  DelayTimeCenter     = 0x0152,    // SC-88 [0x01 - 0x73 : 0x61] 0.1 - 1000 ms
+  DelayTimeRatioLeft  = 0x0153,    // SC-88 [0x01 - 0x78 : 0x01] 4 - 500 %
+  DelayTimeRatioRight = 0x0154,    // SC-88 [0x01 - 0x78 : 0x01] 4 - 500 %
+  DelayLevelCenter    = 0x0155,    // SC-88 [0x00 - 0x7f : 0x7f]
+  DelayLevelLeft      = 0x0156,    // SC-88 [0x00 - 0x7f : 0x00]
+  DelayLevelRight     = 0x0157,    // SC-88 [0x00 - 0x7f : 0x00]
+  DelayLevel          = 0x0158,    // SC-88 [0x00 - 0x7f : 0x40]
+  DelayFeedback       = 0x0159,    // SC-88 [0x00 - 0x7f : 0x50] -64 - 63
+  DelaySendToReverb   = 0x015a,    // SC-88 [0x00 - 0x7f : 0x00]
 
   // The remaining patch paramters have separate values for each part
   // All addresses are either 0x1PXX or 0x2PXX, where P = part number
@@ -124,7 +139,7 @@ enum class PatchParam : int {
   RxBankSelectLSB     = 0x1024,    // (SC88+)
   PitchFineTune       = 0x102a,    // [SC88+][0x0000 - 0x7f7f : 0x400] (14 bit)
   PitchFineTune2      = 0x102b,    // Also RPN #1 so used for that on SC-55
-  DelaySendLevel      = 0x102c,    // (SC88+)
+  DelaySendLevel      = 0x102c,    // (SC88+) [0x00 - 0x7f : 0x00] (CC# 94)
 
   // Tone modify
   // Note: SC-55 has [0x0e - 0x72 : 0x40] for all tone modify parameters
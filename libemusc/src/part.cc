@@ -26,23 +26,25 @@
 
 namespace EmuSC {
 
-Part::Part(uint8_t id, Settings *settings, ControlRom &ctrlRom, PcmRom &pcmRom)
+Part::Part(uint8_t id, Settings *settings, const ControlRom &ctrlRom,
+	   const PcmRom &pcmRom, NotePool *notePool)
   : _id(id),
     _settings(settings),
     _ctrlRom(ctrlRom),
     _pcmRom(pcmRom),
     _7bScale(1/127.0),
     _lastPeakSample(0),
-    _lastPitchBendRange(2),
-    _chorus(NULL)
+    _lastPitchBendRange(2)
 {
   // TODO: Rename mode => synthMode and set proper defaults for MT32 mode
   _notesMutex = new std::mutex();
+  _notePool = notePool;
+  _notes.reserve(notePool->size());
+  _voiceList.resize(notePool->size() * 2);
+  _numPartials = 0;
+  _keyNotes.fill(NULL);
 
-  _partialReserve = 2;           // TODO: Add this to settings with propoer val
   _mute = false;                 // TODO: Also move to settings
-
-  _chorus = new Chorus(settings);
 }
 
 
@@ -50,82 +52,118 @@ Part::~Part()
 {
   delete_all_notes();
   delete _notesMutex;
-
-  delete _chorus;
 }
 
 
 // Parts always produce 2 channel & 32kHz (native) output. Other channel
 // numbers and sample rates are handled by the calling Synth class.
-int Part::get_next_sample(float *sampleOut, float *sysEffect)
+// Samples are rendered in blocks of interleaved stereo frames, and added to
+// sampleOut. The mono chorus, reverb and delay (SC-88) sends are added to
+// the send buffers, while the effects are processed once for all parts by the
+// Synth class.
+int Part::get_next_samples(float *sampleOut, float *chorusSend,
+			   float *reverbSend, float *delaySend, uint32_t frames)
 {
-  float partSample[2] = { 0, 0 };
+  // Parts without notes have no output and nothing to send to effects
+  if (_notes.empty())
+    return 0;
 
-  // Only process notes if we have any
-  if (_notes.size() > 0) {
+  float partSamples[Settings::maxBlockSize * 2] = { 0 };
 
-    // TODO: Figure out a proper way to efficiently calculate new controller
-    //       values when needed. Is PitchBend the only one that needs this?
-    uint8_t pbRng = _settings->get_param(PatchParam::PB_PitchControl, _id) - 0x40;
-    if (pbRng != _lastPitchBendRange) {
-      _lastPitchBendRange = pbRng;
-      _settings->update_pitchBend_factor(_id);
-    }
+  // TODO: Figure out a proper way to efficiently calculate new controller
+  //       values when needed. Is PitchBend the only one that needs this?
+  uint8_t pbRng = _settings->get_param(PatchParam::PB_PitchControl, _id) - 0x40;
+  if (pbRng != _lastPitchBendRange) {
+    _lastPitchBendRange = pbRng;
+    _settings->update_pitchBend_factor(_id);
+  }
 
-    float accSample = 0;
+  _notesMutex->lock();
+
+  // Update control values for all notes, then play, filter and mix all
+  // voices of the part together
+  uint32_t numVoices = 0;
+  for (auto n : _notes)
+    numVoices += n->update(frames, &_voiceList[numVoices]);
 
-    _notesMutex->lock();
+  VoiceTable *voices = _notePool->voices();
+  voices->play(_voiceList.data(), numVoices);
+
+  for (auto n : _notes)
+    n->filter();
 
-    // Get next sample from active notes, delete those which are finished
-    std::list<Note*>::iterator itr = _notes.begin();
-    while (itr != _notes.end()) {
-      bool finished = (*itr)->get_next_sample(partSample);
+  voices->mix(_voiceList.data(), numVoices, partSamples);
 
-      if (finished) {
+  // Return finished notes to the note pool while keeping the remaining notes
+  // in order
+  size_t active = 0;
+  for (size_t i = 0; i < _notes.size(); i++) {
+    if (_notes[i]->finished()) {
 //      std::cout << "Both partials have finished -> delete note" << std::endl;
-	delete *itr;
-	itr = _notes.erase(itr);
-      } else {
-	++itr;
-      }
+      _numPartials -= _notes[i]->get_num_partials();
+      _unlink_key(_notes[i]);
+      _notePool->delete_note(_notes[i]);
+    } else {
+      _notes[active++] = _notes[i];
     }
+  }
+  _notes.resize(active);
 
-    _notesMutex->unlock();
+  _notesMutex->unlock();
 
-    // Apply volume from part (MIDI channel) and expression (CM11)
-    uint8_t expression = _settings->get_param(PatchParam::Expression, _id);
-    partSample[0] *= _settings->get_param(PatchParam::PartLevel, _id) *
-      _7bScale * (expression * _7bScale);
-    partSample[1] *= _settings->get_param(PatchParam::PartLevel, _id) *
-      _7bScale * (expression * _7bScale);
+  // Apply volume from part (MIDI channel) and expression (CM11)
+  uint8_t expression = _settings->get_param(PatchParam::Expression, _id);
+  float volume = _settings->get_param(PatchParam::PartLevel, _id) *
+    _7bScale * (expression * _7bScale);
 
-    // Store last (highest) value for future queries (typically for bar display)
-    _lastPeakSample =
-      (_lastPeakSample >= partSample[0]) ? _lastPeakSample : partSample[0];
-  
-    // Apply pan from part (MIDI Channel)
-    uint8_t panpot = _settings->get_param(PatchParam::PartPanpot, _id);
-    if (panpot > 64)
-      partSample[0] *= 1.0 - (panpot - 64) / 63.0;
-    else if (panpot < 64)
-      partSample[1] *= (panpot - 1) / 64.0;
-
-    sampleOut[0] += partSample[0];
-    sampleOut[1] += partSample[1];
+  // Apply pan from part (MIDI Channel)
+  uint8_t panpot = _settings->get_param(PatchParam::PartPanpot, _id);
+  float panLeft = (panpot > 64) ? 1.0 - (panpot - 64) / 63.0 : 1;
+  float panRight = (panpot < 64) ? (panpot - 1) / 64.0 : 1;
+
+  for (uint32_t i = 0; i < frames; i++) {
+    partSamples[i * 2] *= volume;
+    partSamples[i * 2 + 1] *= volume;
+
+    // Store last (highest) value for future queries (typically for bar
+    // display)
+    if (partSamples[i * 2] > _lastPeakSample)
+      _lastPeakSample = partSamples[i * 2];
+
+    partSamples[i * 2] *= panLeft;
+    partSamples[i * 2 + 1] *= panRight;
+
+    sampleOut[i * 2] += partSamples[i * 2];
+    sampleOut[i * 2 + 1] += partSamples[i * 2 + 1];
   }
 
-  // Add system effects: Chorus and Reverb
+  // Send to system effects
+  float mono[Settings::maxBlockSize];
+  for (uint32_t i = 0; i < frames; i++)
+    mono[i] = (partSamples[i * 2] + partSamples[i * 2 + 1]) / 2;
+
+  uint8_t chorusSendLevel =
+    _settings->get_param(PatchParam::ChorusSendLevel, _id);
+  if (chorusSendLevel) {
+    float cLevel = chorusSendLevel / 127.0;
+    for (uint32_t i = 0; i < frames; i++)
+      chorusSend[i] += mono[i] * cLevel;
+  }
 
-  // Chorus effect (if both global & part chorus levels != 0)
-  if (_settings->get_param(PatchParam::ChorusSendLevel, _id) &&
-      _settings->get_param(PatchParam::ChorusLevel, _id)) {
-    float cLevel = _settings->get_param(PatchParam::ChorusSendLevel, _id)/127.0;
-    float cSample[2] = { 0, 0 };
-    float cInput = ((partSample[0] + partSample[1]) / 2) * cLevel;
-    _chorus->process_sample(cInput, cSample);
+  uint8_t reverbSendLevel =
+    _settings->get_param(PatchParam::ReverbSendLevel, _id);
+  if (reverbSendLevel) {
+    float rLevel = reverbSendLevel / 127.0;
+    for (uint32_t i = 0; i < frames; i++)
+      reverbSend[i] += mono[i] * rLevel;
+  }
 
-    sysEffect[0] += cSample[0] * _settings->get_param(PatchParam::ChorusLevel) / 127.0;
-    sysEffect[1] += cSample[1] * _settings->get_param(PatchParam::ChorusLevel) / 127.0;
+  uint8_t delaySendLevel =
+    _settings->get_param(PatchParam::DelaySendLevel, _id);
+  if (delaySendLevel) {
+    float dLevel = delaySendLevel / 127.0;
+    for (uint32_t i = 0; i < frames; i++)
+      delaySend[i] += mono[i] * dLevel;
   }
 
   return 0;
@@ -146,14 +184,7 @@ float Part::get_last_peak_sample(void)
 
 int Part::get_num_partials(void)
 {
-  if (_notes.size() == 0)
-    return 0;
-
-  int numPartials = 0;
-  for (auto &n: _notes)
-    numPartials += n->get_num_partials();
-
-  return numPartials;
+  return _numPartials;
 }
 
 
@@ -197,11 +228,30 @@ int Part::add_note(uint8_t key, uint8_t keyVelocity)
 
   _notesMutex->lock();
 
-  Note *n = new Note(key, velocity, _ctrlRom, _pcmRom, _settings, _id);
-  _notes.push_back(n);
+  // 7. Drums in an exclusive class (assign group) cut off each other, e.g.
+  //    open and closed hi-hat
+  if (rhythm != mode_Norm) {
+    uint8_t group = _settings->get_param(DrumParam::AssignGroupNumber,
+					 rhythm - 1, key);
+    if (group)
+      _delete_exclusive_class(rhythm - 1, group);
+  }
+
+  Note *n = _notePool->new_note(key, velocity, _ctrlRom, _pcmRom, _settings,
+				_id);
+  if (n) {
+    _notes.push_back(n);
+    _numPartials += n->get_num_partials();
+    _link_key(n);
+  }
 
   _notesMutex->unlock();
 
+  if (!n) {
+    _notePool->count_dropped();
+    return 0;
+  }
+
   if (_settings->get_param(PatchParam::Hold1, _id))
       n->sustain(true);
 
@@ -217,7 +267,7 @@ int Part::add_note(uint8_t key, uint8_t keyVelocity)
 
 int Part::stop_note(uint8_t key)
 {
-  for (auto &n : _notes)
+  for (Note *n = _keyNotes[key & 0x7f]; n; n = n->next_on_key())
     n->stop(key);
 
   return 0;
@@ -240,9 +290,11 @@ int Part::delete_all_notes(void)
 
   int i = _notes.size();
   for (auto n : _notes)
-    delete n;
+    _notePool->delete_note(n);
 
   _notes.clear();
+  _numPartials = 0;
+  _keyNotes.fill(NULL);
 
   _notesMutex->unlock();
 
@@ -250,6 +302,114 @@ int Part::delete_all_notes(void)
 }
 
 
+// Number of partials (voices) reserved for this part. Stored in the Voice
+// Reserve parameter block in the Roland part order.
+uint8_t Part::voice_reserve(void)
+{
+  return _settings->get_param_ptr(PatchParam::PartialReserve)
+    [Settings::convert_to_roland_part_id(_id)];
+}
+
+
+// Find the best note to steal among notes started before the given serial
+// number. Released notes are taken before held notes, and the quietest note
+// by TVA level is taken first. Returns NULL if there are no such notes.
+Note *Part::steal_candidate(uint64_t before)
+{
+  Note *candidate = NULL;
+  float candidateLevel = 0;
+
+  for (auto n : _notes) {
+    if (n->serial() >= before)
+      break;
+
+    float level = n->level();
+    if (!candidate ||
+	(n->released() && !candidate->released()) ||
+	(n->released() == candidate->released() && level < candidateLevel)) {
+      candidate = n;
+      candidateLevel = level;
+    }
+  }
+
+  return candidate;
+}
+
+
+void Part::delete_note(Note *note)
+{
+  _notesMutex->lock();
+
+  auto itr = std::find(_notes.begin(), _notes.end(), note);
+  if (itr != _notes.end()) {
+    _numPartials -= note->get_num_partials();
+    _unlink_key(note);
+    _notePool->delete_note(note);
+    _notes.erase(itr);
+  }
+
+  _notesMutex->unlock();
+}
+
+
+void Part::delete_last_note(void)
+{
+  if (!_notes.empty())
+    delete_note(_notes.back());
+}
+
+
+// Key index helpers, must be called with _notesMutex locked
+void Part::_link_key(Note *note)
+{
+  note->set_next_on_key(_keyNotes[note->key()]);
+  _keyNotes[note->key()] = note;
+}
+
+
+void Part::_unlink_key(Note *note)
+{
+  Note *prev = NULL;
+  for (Note *n = _keyNotes[note->key()]; n; prev = n, n = n->next_on_key()) {
+    if (n == note) {
+      if (prev)
+	prev->set_next_on_key(n->next_on_key());
+      else
+	_keyNotes[note->key()] = n->next_on_key();
+
+      return;
+    }
+  }
+}
+
+
+// Remove all notes belonging to the drum exclusive class (assign group)
+// immediately, returning their voices to the note pool. Only the key chains
+// of the keys in the group are visited.
+void Part::_delete_exclusive_class(uint8_t map, uint8_t group)
+{
+  const std::vector<uint8_t> &keys =
+    _settings->get_assign_group_keys(map, group);
+
+  for (size_t k = 0; k < keys.size(); k++) {
+    Note *n = _keyNotes[keys[k]];
+    _keyNotes[keys[k]] = NULL;
+
+    while (n) {
+      Note *next = n->next_on_key();
+      std::vector<Note*>::iterator itr = std::find(_notes.begin(),
+						   _notes.end(), n);
+      if (itr != _notes.end())
+	_notes.erase(itr);
+
+      _numPartials -= n->get_num_partials();
+      _notePool->delete_note(n);
+      n = next;
+    }
+  }
+}
+
+
 int Part::control_change(uint8_t msgId, uint8_t value)
 {
   // RxControlChange does not affect Channel Mode messages
@@ -392,6 +552,11 @@ int Part::control_change(uint8_t msgId, uint8_t value)
     _settings->set_param(PatchParam::ChorusSendLevel, value, _id);
     updateGUI = true;
 
+  } else if (msgId == 94 &&                            // Delay (SC-88)
+	     _ctrlRom.generation() >= ControlRom::SynthGen::SC88) {
+    _settings->set_param(PatchParam::DelaySendLevel, value, _id);
+    updateGUI = true;
+
   } else if (msgId == 98) {                            // NRPN LSB
     if (_settings->get_param(PatchParam::RxNRPN, _id))
       _settings->set_param(PatchParam::NRPN_LSB, value, _id);
@@ -501,8 +666,6 @@ void Part::reset(void)
 {
   delete_all_notes();
 
-  _partialReserve = 2;
-
   _mute = false;
   _lastPeakSample = 0;
 }
@@ -21,16 +21,15 @@
 #define __PART_H__
 
 
-#include "chorus.h"
 #include "control_rom.h"
 #include "pcm_rom.h"
 #include "note.h"
+#include "note_pool.h"
 #include "settings.h"
 
 #include <stdint.h>
 
 #include <array>
-#include <list>
 #include <mutex>
 #include <vector>
 
@@ -40,10 +39,12 @@ namespace EmuSC {
 class Part
 {
 public:
-  Part(uint8_t id, Settings *settings, ControlRom &cRom, PcmRom &pRom);
+  Part(uint8_t id, Settings *settings, const ControlRom &cRom,
+       const PcmRom &pRom, NotePool *notePool);
   ~Part();
 
-  int get_next_sample(float *sampleOut, float *sysEffect);
+  int get_next_samples(float *sampleOut, float *chorusSend, float *reverbSend,
+		       float *delaySend, uint32_t frames);
   float get_last_peak_sample(void);
   int get_num_partials(void);
 
@@ -60,6 +61,12 @@ public:
   int delete_all_notes(void);
   int stop_all_notes(void);
 
+  // Voice stealing at voice limit
+  uint8_t voice_reserve(void);
+  Note *steal_candidate(uint64_t before);
+  void delete_note(Note *note);
+  void delete_last_note(void);
+
   void reset(void);
 
   uint8_t id(void) { return _id; }
@@ -77,8 +84,6 @@ private:
   uint16_t _instrument;       // [0-127] -> variation table
   int8_t _drumSet;            // [0-13] drumSet (SC-55)
 
-  uint8_t _partialReserve;    // [0-24] Default 2
-
   bool _mute;                 // Part muted
 
   const double _7bScale;      // Constant: 1 / 127
@@ -91,18 +96,26 @@ private:
     mode_Drum2 = 2
   };
 
-  struct std::list<Note*> _notes;
-  std::mutex *_notesMutex;
+  std::vector<Note*> _notes;   // Active notes in start order
+  std::vector<uint32_t> _voiceList;  // Voice table indexes of active partials
+  int _numPartials;            // Partials used by active notes
 
-  ControlRom &_ctrlRom;
-  PcmRom &_pcmRom;
+  // Active notes for each key. Notes with the same key are chained together.
+  std::array<Note*, 128> _keyNotes;
+  std::mutex *_notesMutex;
+  NotePool *_notePool;
 
-  Chorus *_chorus;
+  const ControlRom &_ctrlRom;
+  const PcmRom &_pcmRom;
 
   // Calculated controller values (minimize number of calculations)
   // TODO: Figure out how to do this properly. Only relevant for pitchBend?
   uint8_t _lastPitchBendRange;
 
+  void _link_key(Note *note);
+  void _unlink_key(Note *note);
+  void _delete_exclusive_class(uint8_t map, uint8_t group);
+
 };
 
 }
@@ -40,6 +40,7 @@
 
 
 #include "partial.h"
+#include "fast_math.h"
 
 #include <iostream>
 #include <cmath>
@@ -49,23 +50,16 @@ namespace EmuSC {
 
 
 Partial::Partial(uint8_t key, int partialId, uint16_t instrumentIndex,
-		 ControlRom &ctrlRom, PcmRom &pcmRom, WaveGenerator *LFO[2],
-		 Settings *settings, int8_t partId)
+		 const ControlRom &ctrlRom, const PcmRom &pcmRom,
+		 WaveGenerator *LFO[2], Settings *settings, int8_t partId,
+		 VoiceTable *voices, uint32_t voice)
   : _key(key),
     _instPartial(ctrlRom.instrument(instrumentIndex).partials[partialId]),
-    _index(0),
-    _direction(1),
-    _sample(0),
+    _voices(voices),
+    _voice(voice),
     _settings(settings),
     _partId(partId),
-    _keyFreq(440 * exp(log(2) * (key - 69) / 12)),
-    _expFactor(log(2) / 12000),
-    _lastPos(0),
-    _rf1(32000, 15),
-    _rf2(32000, 15),
-    _tvp(NULL),
-    _tvf(NULL),
-    _tva(NULL)
+    _keyFreq(440 * exp(log(2) * (key - 69) / 12))
 {
   _isDrum = settings->get_param(PatchParam::UseForRhythm, partId);
 
@@ -97,9 +91,12 @@ Partial::Partial(uint8_t key, int partialId, uint16_t instrumentIndex,
     }
   }
 
-  // 3. Update internal class data pointers
-  _pcmSamples = &pcmRom.samples(sampleIndex).samplesF;
+  // 3. Update internal class data pointers and start sample playback
   _ctrlSample = &ctrlRom.sample(sampleIndex);
+  Interpolator::Mode interpolation = Interpolator::Mode::Linear;
+  if (settings->get_param(SystemParam::Interpolation) == 1)
+    interpolation = Interpolator::Mode::Cubic;
+  voices->start(voice, pcmRom.samples(sampleIndex), interpolation);
 
   // 4. Find actual difference in key between NoteOn and sample
   if (_isDrum) {
@@ -124,23 +121,41 @@ Partial::Partial(uint8_t key, int partialId, uint16_t instrumentIndex,
 	 * log(2) / 1200))
     * 32000.0 / settings->get_param_uint32(SystemParam::SampleRate);
 
+  // 6. Calculate static volume from sample, partial and drum set definitions
+  //    (7f - 0) and panpot (stereo positioning). These are fixed at note on.
+  double sampleVol = _convert_volume(_ctrlSample->volume +
+				     ((_ctrlSample->fineVolume- 1024) /1000.0));
+  double partialVol = _convert_volume(_instPartial.volume);
+
+  double drumVol = 1;
+  if (_isDrum)
+    drumVol = _convert_volume(settings->get_param(DrumParam::Level, _drumMap,
+						  _key));
+
+  _staticVolume = sampleVol * partialVol * drumVol;
+
+  double panpot;
+  if (!_isDrum)
+    panpot = (_instPartial.panpot - 0x40) / 64.0;
+  else
+    panpot = (settings->get_param(DrumParam::Panpot, _drumMap, _key) - 0x40) / 64.0;
+
+  voices->set_pan(voice, (panpot > 0) ? 1 - panpot : 1,
+		  (panpot < 0) ? 1 + panpot : 1);
+
   // 1. Pitch: Vibrato & TVP envelope
-  _tvp = new TVP(_instPartial, LFO, settings, partId);
+  _tvp.create(_instPartial, LFO, settings, partId);
 
   // 2. Filter: ?wah? & TVF envelope
-  _tvf = new TVF(_instPartial, key, LFO, settings, partId);
+  _tvf.create(_instPartial, key, LFO, settings, partId);
 
   // 3. Volume: Tremolo & TVA envelope
-  _tva = new TVA(_instPartial, key, LFO, settings, partId);
+  _tva.create(_instPartial, key, LFO, settings, partId);
 }
 
 
 Partial::~Partial()
-{
-  delete _tvp;
-  delete _tvf;
-  delete _tva;
-}
+{}
 
 
 void Partial::stop(void)
@@ -155,13 +170,15 @@ void Partial::stop(void)
 }
 
 
-// Pitch is the only variable input for a note's get_next_sample
-// Pitch < 0 => fixed pitch (e.g. for drums)
-bool Partial::get_next_sample(float *noteSample)
+// Update control values for a block. Static volume and pan are set at note
+// on, while tuning and controller volume are updated once per block.
+void Partial::update(uint32_t frames)
 {
-  // Terminate this partial if its TVA envelope is finished
-  if  (_tva->finished())
-    return 1;
+  // Nothing more to play if the TVA envelope is finished
+  if  (_tva->finished()) {
+    _voices->set_frames(_voice, 0);
+    return;
+  }
 
   float freqKeyTuned = _keyFreq +
     (_settings->get_param_nib16(PatchParam::PitchOffsetFine,_partId) -0x080)/10;
@@ -173,169 +190,45 @@ bool Partial::get_next_sample(float *noteSample)
                    ((_settings->get_param_uint16(PatchParam::PitchFineTune,
 						 _partId) - 8192) / 8.192);
 
-  float pitchAdj = exp(pitchExp * _expFactor) *
+  float pitchAdj = FastMath::exp2(pitchExp / 12000) *
                    pitchOffsetHz *
                    _settings->get_pitchBend_factor(_partId) *
-                   _staticPitchTune *
-                   _tvp->get_pitch();
-
-  if (_next_sample_from_rom(pitchAdj))
-    return 1;
-
-  double sample[2] = {0, 0};
-  sample[0] = _sample;
-
-  // TODO: Move all static volume calculations to constructor
-  // Calculate volume correction from sample definition (7f - 0)
-  double sampleVol = _convert_volume(_ctrlSample->volume +
-				     ((_ctrlSample->fineVolume- 1024) /1000.0));
-
-  // Calculate volume correction from partial definition (7f - 0)
-  double partialVol = _convert_volume(_instPartial.volume);
-
-  // Calculate volume correction from drum set definition
-  double drumVol = 1;
-  if (_isDrum)
-    drumVol = _convert_volume(_settings->get_param(DrumParam::Level, _drumMap,
-						   _key));
+                   _staticPitchTune;
 
+  // Only the controller volume changes during the lifetime of the partial
   float ctrlVol = _settings->get_param(PatchParam::Acc_AmplitudeControl, _partId) / 64.0;
-
-  // Apply volume changes
-  sample[0] *= sampleVol * partialVol * drumVol * ctrlVol;
-
-  // Apply TVF
-// NOTE: TEMPORARILY DISABLED
-//  sample[0] = _tvf->apply(sample[0]);
-
-  // Apply TVA
-  sample[0] *= _tva->get_amplification();
-
-  // Make both channels equal before adding pan (stereo position)
-  sample[1] = sample[0];
-
-  // Add panpot (stereo positioning of sounds)
-  double panpot;
-  if (!_isDrum)
-    panpot = (_instPartial.panpot - 0x40) / 64.0;
-  else
-    panpot = (_settings->get_param(DrumParam::Panpot, _drumMap, _key) - 0x40) / 64.0;
-
-  if (panpot < 0)
-    sample[1] *= (1 + panpot);
-  else if (panpot > 0)
-    sample[0] *= (1 - panpot);
-
-  // Finally add samples to the sample pointers (always 2 channels / stereo)
-  noteSample[0] += sample[0];
-  noteSample[1] += sample[1];
-
-  return 0;
+  _voices->set_volume(_voice, _staticVolume * ctrlVol);
+
+  // Dynamic pitch (vibrato & TVP envelope) and volume (tremolo & TVA envelope)
+  // are written directly to the voice table control arrays
+  float *increment = _voices->increment(_voice);
+  _tvp->get_pitch(increment, frames);
+  for (uint32_t i = 0; i < frames; i++)
+    increment[i] *= pitchAdj;
+
+  // The TVA envelope may end before the block is complete
+  _voices->set_frames(_voice,
+		      _tva->get_amplification(_voices->gain(_voice), frames));
 }
 
 
-bool Partial::_next_sample_from_rom(float pitchAdj)
+void Partial::filter(void)
 {
-  if (_direction == 1) {   // Update sample position going in forward direction
-    if (0)
-      std::cout << "-> FW " << std::dec << "pos=" << (int) _index
-		<< " pa=" << pitchAdj
-		<< " np=" << _index + pitchAdj
-		<< " sl=" << (int) _ctrlSample->sampleLen
-		<< " lm=" << (int) _ctrlSample->loopMode
-		<< " ll=" << _ctrlSample->loopLen
-		<< " lp=" << _lastPos
-		<< std::endl;
-
-    _index += pitchAdj;
-
-    while (roundf(_index) > _lastPos && _lastPos < _ctrlSample->sampleLen - 1) {
-      _sample = _rf1.apply(_pcmSamples->at(_lastPos++));
-      _sample = _rf2.apply(_sample);
-    }
-
-    // Check for sample position passing sample boundary
-    if (_index > _ctrlSample->sampleLen - 1) {      // -1 due to lin. interpol.
-      // Keep track of correct sample index when switching sample direction
-      float remaining = abs(_ctrlSample->sampleLen - _index);
-
-      // loopMode == 0 => Forward only w/loop (jump back "loopLen + 1")
-      if (_ctrlSample->loopMode == 0) {
-	_index = _ctrlSample->sampleLen - _ctrlSample->loopLen - 1 + remaining;
-	_lastPos = _ctrlSample->sampleLen - _ctrlSample->loopLen - 1;
-
-	// Filter any remainging samples
-	while (roundf(_index) > _lastPos) {
-	  _sample = _rf1.apply(_pcmSamples->at(_lastPos++));
-	  _sample = _rf2.apply(_sample);
-	}
-
-      // loopMode == 1 => Forward-backward (start moving backwards)
-      } else if (_ctrlSample->loopMode == 1) {
-	_index = _ctrlSample->sampleLen - remaining - 1;
-	_direction = 0;
-
-	// Filter any remainging samples
-	while (roundf(_index) < _lastPos) {
-	  _sample = _rf1.apply(_pcmSamples->at(_lastPos--));
-	  _sample = _rf2.apply(_sample);
-	}
-
-      // loopMode == 2 => Forward-stop (end playback)
-      } else if (_ctrlSample->loopMode == 2) {
-	return 1;                                 // Terminate this partial
-      }
-    }
-
-  } else {              // Update sample position going in backward direction
-    if (0)
-      std::cout << "<- BW " << std::dec << "pos=" << (int) _index
-		<< " sl=" << (int) _ctrlSample->sampleLen
-		<< " ll=" << _ctrlSample->loopLen
-		<< " lp=" << _lastPos
-		<< std::endl;
-
-    // Update partial sample position based on pitch input
-    _index -= pitchAdj;
-
-    while (roundf(_index) < _lastPos &&
-	   _lastPos > _ctrlSample->sampleLen - _ctrlSample->loopLen) {
-      _sample = _rf1.apply(_pcmSamples->at(_lastPos--));
-      _sample = _rf2.apply(_sample);
-    }
-
-    // Check for sample position passing sample boundary
-    if (_index < _ctrlSample->sampleLen - _ctrlSample->loopLen - 1) {
-
-      // Filter any remainging samples backward
-      while (_lastPos > _ctrlSample->sampleLen - _ctrlSample->loopLen - 1) {
-	_sample = _rf1.apply(_pcmSamples->at(_lastPos--));
-	_sample = _rf2.apply(_sample);
-      }
-
-      // Keep track of correct position switching position
-      float remaining = _ctrlSample->sampleLen - _ctrlSample->loopLen - _index;
-
-      // Start moving forward
-      _index = _ctrlSample->sampleLen - _ctrlSample->loopLen + remaining;
-      _direction = 1;
+  _tvf->apply(_voices->samples(_voice), _voices->frames(_voice));
+}
 
-      // Filter any remainging samples forward
-      _lastPos = _ctrlSample->sampleLen - _ctrlSample->loopLen;
-      while (roundf(_index) < _lastPos) {
-	_sample = _rf1.apply(_pcmSamples->at(_lastPos++));
-	_sample = _rf2.apply(_sample);
-      }
-    }
-  }
 
-  return 0;
+// Returns true when the sample or the TVA envelope has ended and the partial
+// can be deleted
+bool Partial::finished(void)
+{
+  return _voices->ended(_voice) || _tva->finished();
 }
 
 
 double Partial::_convert_volume(uint8_t volume)
 {
-  return (0.1 * pow(2.0, (double)(volume) / 36.7111) - 0.1);
+  return (0.1 * FastMath::exp2(volume / 36.7111f) - 0.1);
 }
 
 }
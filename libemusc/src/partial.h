@@ -22,12 +22,13 @@
 
 
 #include "control_rom.h"
-#include "riaa_filter.h"
+#include "in_place.h"
 #include "pcm_rom.h"
 #include "settings.h"
 #include "tva.h"
 #include "tvf.h"
 #include "tvp.h"
+#include "voice_table.h"
 #include "wave_generator.h"
 
 #include <stdint.h>
@@ -40,12 +41,25 @@ class Partial
 {
 public:
   Partial(uint8_t key, int partialId, uint16_t instrumentIndex,
-	  ControlRom &controlRom, PcmRom &pcmRom, WaveGenerator *LFO[2],
-	  Settings *settings, int8_t partId);
+	  const ControlRom &controlRom, const PcmRom &pcmRom,
+	  WaveGenerator *LFO[2], Settings *settings, int8_t partId,
+	  VoiceTable *voices, uint32_t voice);
   ~Partial();
 
   void stop(void);
-  bool get_next_sample(float *sampleOut);
+
+  // Blocks are rendered in stages. update() writes pitch and gain control
+  // values and the number of frames to play to the voice table. After the
+  // voice table has played all voices of the part, filter() applies the TVF
+  // to the played samples before they are mixed.
+  void update(uint32_t frames);
+  void filter(void);
+  bool finished(void);
+
+  uint32_t voice(void) { return _voice; }
+
+  // Static volume times the TVA envelope level
+  float level(void) { return _staticVolume * _tva->level(); }
 
 private:
   uint8_t _key;           // MIDI key number for note on
@@ -53,18 +67,14 @@ private:
   float _keyDiff;         // Difference in number of keys from original tone
                           // If pitchKeyFollow is used, keyDiff is adjusted
 
-  struct ControlRom::InstPartial &_instPartial;
-  struct ControlRom::Sample *_ctrlSample;
-
-  std::vector<float> *_pcmSamples;
+  const struct ControlRom::InstPartial &_instPartial;
+  const struct ControlRom::Sample *_ctrlSample;
 
-  unsigned int _lastPos;  // Last read sample position
-  float _index;           // Sample position in number of samples from start
-  bool _direction;        // Sample read direction: 0 = backward & 1 = foreward
-
-  float _expFactor;       // log(2) / 12000
+  VoiceTable *_voices;    // Sample playback state is kept in the voice table
+  uint32_t _voice;
 
   float _staticPitchTune;
+  double _staticVolume;   // Sample, partial and drum set volume
 
   Settings *_settings;
   int8_t _partId;
@@ -72,16 +82,10 @@ private:
   bool _isDrum;
   int _drumMap;
 
-  TVP *_tvp;
-  TVF *_tvf;
-  TVA *_tva;
-
-  RiaaFilter _rf1;
-  RiaaFilter _rf2;
-
-  double _sample;
+  InPlace<TVP> _tvp;
+  InPlace<TVF> _tvf;
+  InPlace<TVA> _tva;
 
-  bool _next_sample_from_rom(float pitchAdj);
   double _convert_volume(uint8_t volume);
 
 };
@@ -21,16 +21,19 @@
 
 
 #include "pcm_rom.h"
+#include "riaa_filter.h"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <utility>
 
 
 namespace EmuSC {
 
 
-PcmRom::PcmRom(std::vector<std::string> romPath, ControlRom &ctrlRom)
+PcmRom::PcmRom(std::vector<std::string> romPath, const ControlRom &ctrlRom)
 {
   std::vector<char> romData;
 
@@ -135,12 +138,14 @@ uint32_t PcmRom::_find_samples_rom_address(uint32_t address)
 }
 
 
-int PcmRom::_read_samples(std::vector<char> &romData, struct ControlRom::Sample &ctrlSample)
+int PcmRom::_read_samples(std::vector<char> &romData,
+			  const struct ControlRom::Sample &ctrlSample)
 {
   uint32_t romAddress = _find_samples_rom_address(ctrlSample.address);
 
-  struct Samples s;
-  s.samplesF.reserve(ctrlSample.sampleLen);
+  // Unfiltered samples are only needed while building the filtered samples
+  std::vector<float> samplesF;
+  samplesF.reserve(ctrlSample.sampleLen);
 
   // Read PCM samples from ROM
   for (int i = 0; i < ctrlSample.sampleLen; i++) {
@@ -153,12 +158,74 @@ int PcmRom::_read_samples(std::vector<char> &romData, struct ControlRom::Sample
     // Convert to float
     float ffinal = (float) final / (1 << 31);
 
-    s.samplesF.push_back(ffinal);
+    samplesF.push_back(ffinal);
+  }
+
+  struct Samples s;
+  _filter_samples(s, samplesF, ctrlSample);
+
+  int numSamples = samplesF.size();
+  _sampleSets.push_back(std::move(s));
+
+  return numSamples;
+}
+
+
+// The RIAA filters are applied to the ROM samples in the order they are
+// played, so the filter state follows the playback path through loops:
+//  loopMode == 0 => Forward only w/loop (jump from loop end to loop start)
+//  loopMode == 1 => Forward-backward (turn at loop end and loop start)
+//  loopMode == 2 => Forward-stop (end playback)
+// Since the filters are linear, the output of each loop period converges
+// after a few time constants. Periods are unrolled until _loopSettleLen
+// samples have been played, and the last period is then used for all
+// further repetitions.
+void PcmRom::_filter_samples(struct Samples &s,
+			     const std::vector<float> &samplesF,
+			     const struct ControlRom::Sample &ctrlSample)
+{
+  const int sampleLen = samplesF.size();
+  const int loopEnd = sampleLen - 1;
+  const int loopLen = std::min(std::max((int) ctrlSample.loopLen, 1),
+			       sampleLen - 1);
+  const int loopStart = loopEnd - loopLen;
+  const uint8_t loopMode = (sampleLen < 2) ? 2 : ctrlSample.loopMode;
+
+  RiaaFilter rf1(32000, 15);
+  RiaaFilter rf2(32000, 15);
+
+  if (loopMode == 2) {
+    s.filtered.reserve(sampleLen);
+    for (int i = 0; i < sampleLen; i++)
+      s.filtered.push_back(rf2.apply(rf1.apply(samplesF[i])));
+
+    s.loopStart = 0;
+    s.loopLen = 0;
+    return;
   }
 
-  _sampleSets.push_back(s);
+  // Samples before the first repetition and length of one loop period
+  int attack = (loopMode == 0) ? loopEnd : loopEnd + 1;
+  int period = (loopMode == 0) ? loopLen : loopLen * 2;
+  int periods = (_loopSettleLen + period - 1) / period + 1;
+  int length = attack + periods * period + 3;
+
+  s.filtered.reserve(length);
+  for (int i = 0; i < length; i++) {
+    int source = i;
+    if (i >= attack) {
+      int p = (i - attack) % period;
+      if (loopMode == 0)
+	source = loopStart + p;
+      else
+	source = (p < loopLen) ? loopEnd - 1 - p : loopStart + 1 + p - loopLen;
+    }
 
-  return s.samplesF.size();
+    s.filtered.push_back(rf2.apply(rf1.apply(samplesF[source])));
+  }
+
+  s.loopStart = attack + (periods - 1) * period;
+  s.loopLen = period;
 }
-  
+
 }
@@ -36,32 +36,51 @@ namespace EmuSC {
 
 class PcmRom
 {
+public:
+  struct Samples {
+//  std::vector<int32_t> samplesI;    // All samples stored in 24 bit 32kHz mono
+
+    // RIAA filtered samples in playback order, with forward and ping-pong
+    // loops unrolled until the filter has settled. Playback repeats the last
+    // period [loopStart, loopStart + loopLen) and stops at the end for
+    // samples without loop. 3 extra samples follow the last period for
+    // interpolation.
+    std::vector<float>   filtered;
+    uint32_t loopStart;
+    uint32_t loopLen;                 // 0 = No loop
+  };
+
 private:
   std::string _version;
   std::string _date;
 
-  struct Samples {
-//  std::vector<int32_t> samplesI;    // All samples stored in 24 bit 32kHz mono
-    std::vector<float>   samplesF;    // 32 bit float, 32kHz, mono
-  };
   std::vector<struct Samples> _sampleSets;
 
   uint32_t _unscramble_address(uint32_t address);
   int8_t   _unscramble_data(int8_t byte);
 
   uint32_t _find_samples_rom_address(uint32_t address);
-  int _read_samples(std::vector<char> &rom, struct ControlRom::Sample &ctrlSample);
+  int _read_samples(std::vector<char> &rom,
+		    const struct ControlRom::Sample &ctrlSample);
+  void _filter_samples(struct Samples &s, const std::vector<float> &samplesF,
+		       const struct ControlRom::Sample &ctrlSample);
+
+  // Number of loop samples run through the RIAA filters before the loop is
+  // considered settled. Filter time constant is ~100 samples.
+  static const uint32_t _loopSettleLen = 1024;
 
   PcmRom();
 
 public:
-  PcmRom(std::vector<std::string> romPath, ControlRom &ctrlRom);
+  PcmRom(std::vector<std::string> romPath, const ControlRom &ctrlRom);
   ~PcmRom();
 
-  inline struct Samples& samples(uint16_t ss) { return _sampleSets[ss]; }
+  // Decoded samples are read-only and can be shared by any number of Synth
+  // instances and threads.
+  inline const struct Samples& samples(uint16_t ss) const { return _sampleSets[ss]; }
 
-  std::string version(void) { return _version; }
-  std::string date(void) { return _date; }
+  std::string version(void) const { return _version; }
+  std::string date(void) const { return _date; }
 };
 
 }
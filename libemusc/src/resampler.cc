@@ -0,0 +1,205 @@
+/*  
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "resampler.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+
+namespace EmuSC {
+
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+  while (b) {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+
+  return a;
+}
+
+
+Resampler::Resampler(uint32_t inRate, uint32_t outRate, enum Quality quality)
+  : _bufFrames(0),
+    _pos(0),
+    _phaseAcc(0)
+{
+  uint32_t g = gcd(inRate, outRate);
+  _L = outRate / g;
+  _M = inRate / g;
+  _phases = (_L > 1024) ? 1024 : _L;
+
+  float rolloff;
+  double beta;
+  switch (quality)
+    {
+    case Quality::Low:    _taps = 8;  rolloff = 0.85; beta = 6;  break;
+    case Quality::High:   _taps = 32; rolloff = 0.95; beta = 10; break;
+    case Quality::Medium:
+    default:              _taps = 16; rolloff = 0.91; beta = 8;  break;
+    }
+
+  // When downsampling the cutoff is below input Nyquist, so more taps are
+  // needed for the same transition band
+  double ratio = (double) outRate / inRate;
+  if (ratio < 1)
+    _taps = ((uint32_t) std::ceil(_taps / ratio) + 3) & ~3u;
+
+  // Cutoff in cycles per input sample
+  double cutoff = 0.5 * ((ratio < 1) ? ratio : 1) * rolloff;
+  double halfWidth = _taps / 2.0;
+
+  // Coefficients for phase p are the kernel sampled at the input frames
+  // around output position (center + p / phases)
+  _coeffs.resize(_phases * _taps);
+  for (uint32_t p = 0; p < _phases; p++) {
+    double frac = (double) p / _phases;
+    double sum = 0;
+
+    for (uint32_t j = 0; j < _taps; j++) {
+      double t = (double) j - (halfWidth - 1) - frac;
+      double x = 2 * cutoff * t;
+      double sinc = (x == 0) ? 1 : std::sin(M_PI * x) / (M_PI * x);
+      double w = t / halfWidth;
+      double window = (std::fabs(w) >= 1) ? 0 :
+	_bessel_i0(beta * std::sqrt(1 - w * w)) / _bessel_i0(beta);
+
+      _coeffs[p * _taps + j] = 2 * cutoff * sinc * window;
+      sum += _coeffs[p * _taps + j];
+    }
+
+    // Normalize each phase to unity DC gain
+    for (uint32_t j = 0; j < _taps; j++)
+      _coeffs[p * _taps + j] /= sum;
+  }
+
+  // Start with zeroed history so that first output is aligned to first input
+  _bufL.assign(_taps + maxInputFrames, 0);
+  _bufR.assign(_taps + maxInputFrames, 0);
+  _bufFrames = _taps / 2 - 1;
+}
+
+
+Resampler::~Resampler()
+{}
+
+
+void Resampler::push(const float *in, uint32_t frames)
+{
+  // Move unconsumed history to start of buffers
+  if (_pos > 0) {
+    uint32_t remaining = _bufFrames - _pos;
+    std::memmove(&_bufL[0], &_bufL[_pos], remaining * sizeof(float));
+    std::memmove(&_bufR[0], &_bufR[_pos], remaining * sizeof(float));
+    _bufFrames = remaining;
+    _pos = 0;
+  }
+
+  if (_bufFrames + frames > _bufL.size())
+    frames = _bufL.size() - _bufFrames;
+
+  for (uint32_t i = 0; i < frames; i++) {
+    _bufL[_bufFrames + i] = in[i * 2];
+    _bufR[_bufFrames + i] = in[i * 2 + 1];
+  }
+
+  _bufFrames += frames;
+}
+
+
+uint32_t Resampler::process(float *out, uint32_t frames)
+{
+  uint32_t n = 0;
+
+  while (n < frames) {
+    // With fewer coefficient sets than output phases the nearest set is
+    // used, which may be the first set of the next input frame
+    uint32_t pos = _pos;
+    uint32_t phase = _phaseAcc;
+    if (_phases != _L) {
+      phase = ((uint64_t) _phaseAcc * _phases + _L / 2) / _L;
+      if (phase == _phases) {
+	phase = 0;
+	pos++;
+      }
+    }
+
+    if (pos + _taps > _bufFrames)
+      break;
+
+    const float *c = &_coeffs[phase * _taps];
+    const float *l = &_bufL[pos];
+    const float *r = &_bufR[pos];
+
+    // Four independent accumulators lets the compiler use SIMD registers
+    // without reordering floating point additions
+    float accL[4] = { 0, 0, 0, 0 };
+    float accR[4] = { 0, 0, 0, 0 };
+    for (uint32_t j = 0; j < _taps; j += 4) {
+      for (int k = 0; k < 4; k++) {
+	accL[k] += c[j + k] * l[j + k];
+	accR[k] += c[j + k] * r[j + k];
+      }
+    }
+
+    out[n * 2] = (accL[0] + accL[1]) + (accL[2] + accL[3]);
+    out[n * 2 + 1] = (accR[0] + accR[1]) + (accR[2] + accR[3]);
+    n++;
+
+    _phaseAcc += _M;
+    _pos += _phaseAcc / _L;
+    _phaseAcc %= _L;
+  }
+
+  return n;
+}
+
+
+uint32_t Resampler::lookahead(void)
+{
+  uint32_t center = _pos + _taps / 2;
+  return (_bufFrames > center) ? _bufFrames - center : 0;
+}
+
+
+// Zeroth order modified Bessel function of the first kind, used for the
+// Kaiser window
+double Resampler::_bessel_i0(double x)
+{
+  double sum = 1;
+  double term = 1;
+
+  for (int k = 1; k < 50; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+
+  return sum;
+}
+
+}
@@ -0,0 +1,88 @@
+/*  
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Polyphase windowed sinc resampler converting the stereo output from the
+// internal 32 kHz engine to the audio device sample rate. The conversion ratio
+// is reduced to L/M, and one set of filter coefficients is precalculated for
+// each of the L output phases (max 1024, larger L uses nearest phase).
+
+
+#ifndef __RESAMPLER_H__
+#define __RESAMPLER_H__
+
+
+#include <stdint.h>
+
+#include <vector>
+
+
+namespace EmuSC {
+
+class Resampler
+{
+public:
+  enum class Quality {
+    Low,                      // 8 taps per phase
+    Medium,                   // 16 taps per phase
+    High                      // 32 taps per phase
+  };
+
+  Resampler(uint32_t inRate, uint32_t outRate, enum Quality quality);
+  ~Resampler();
+
+  // Add interleaved stereo input frames. At most maxInputFrames can be
+  // buffered before process() has consumed them.
+  void push(const float *in, uint32_t frames);
+
+  // Write up to 'frames' interleaved stereo output frames. Returns number of
+  // frames written, less than requested if more input is needed.
+  uint32_t process(float *out, uint32_t frames);
+
+  // Number of input frames pushed beyond the input position of the next
+  // output frame. Output is aligned to input, so this is how far the input
+  // runs ahead of the output, including the filter lookahead of taps / 2.
+  uint32_t lookahead(void);
+
+  // Upper limit for lookahead() after pushing a block of input frames
+  uint32_t max_lookahead(uint32_t blockFrames)
+  { return _taps / 2 + blockFrames; }
+
+  static const uint32_t maxInputFrames = 256;
+
+private:
+  uint32_t _L;                // Interpolation factor
+  uint32_t _M;                // Decimation factor
+  uint32_t _phases;           // Number of coefficient sets
+  uint32_t _taps;             // Coefficients per phase (multiple of 4)
+
+  std::vector<float> _coeffs; // _phases * _taps
+
+  std::vector<float> _bufL;   // Planar input history + new input
+  std::vector<float> _bufR;
+  uint32_t _bufFrames;        // Number of valid frames in buffers
+  uint32_t _pos;              // First input frame for next output frame
+  uint32_t _phaseAcc;         // Fractional position in units of 1/L
+
+  static double _bessel_i0(double x);
+
+  Resampler();
+};
+
+}
+
+#endif  // __RESAMPLER_H__
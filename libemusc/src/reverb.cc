@@ -0,0 +1,290 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The comb filters are feedback comb filters with a one pole lowpass filter
+// in the feedback loop, as used in the Freeverb algorithm. Feedback gains are
+// calculated from the delay length of each comb filter so that all combs
+// decay 60 dB over the same reverb time.
+//
+// Reverb times, room sizes and damping for each character are not measured
+// on real hardware and are just rough estimates for now.
+
+
+#include "reverb.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+
+namespace EmuSC {
+
+
+const std::array<Reverb::Preset, 6> Reverb::_presets = {{
+  { 0.55, 0.8, 0.35 },         // Room 1
+  { 0.70, 1.1, 0.30 },         // Room 2
+  { 0.85, 1.5, 0.25 },         // Room 3
+  { 1.00, 2.2, 0.25 },         // Hall 1
+  { 1.20, 3.0, 0.20 },         // Hall 2
+  { 0.60, 2.0, 0.05 } }};      // Plate
+
+const std::array<float, Reverb::numCombs> Reverb::_combTime = {{
+  25.3, 26.9, 29.0, 30.7 }};
+
+const std::array<float, Reverb::numAllpass> Reverb::_allpassTime = {{
+  5.0, 1.7 }};
+
+
+Reverb::Reverb(Settings *settings)
+  : _settings(settings),
+    _sampleRate(settings->get_param_uint32(SystemParam::SampleRate)),
+    _character(0xff),
+    _preLPF(0xff),
+    _time(0xff),
+    _delayFeedback(0xff),
+    _lpFilter(_sampleRate),
+    _dcPole(std::exp(-2 * M_PI * 20.0 / _sampleRate)),   // 20 Hz
+    _dcIn(0),
+    _dcOut(0),
+    _damp(0),
+    _delayLength(1),
+    _writeIndex(0),
+    _feedback(0)
+{
+  // Right channel delays are longer to decorrelate the channels
+  uint32_t spread = 23 * _sampleRate / 44100;
+
+  float maxSize = 0;
+  for (auto &p : _presets)
+    maxSize = std::max(maxSize, p.size);
+
+  _combCapacity = _combTime.back() * maxSize * _sampleRate / 1000 + spread + 1;
+  _combBuffer.resize(_combCapacity * numCombs * 2);
+
+  _allpassCapacity = _allpassTime.front() * _sampleRate / 1000 + spread + 1;
+  _allpassBuffer.resize(_allpassCapacity * numAllpass * 2);
+
+  for (int ch = 0; ch < 2; ch++)
+    for (int a = 0; a < numAllpass; a++)
+      _allpassLength[ch * numAllpass + a] =
+	_allpassTime[a] * _sampleRate / 1000 + ch * spread;
+
+  // Max delay time is 512 ms, rounded up to a power of 2
+  uint32_t frames = 1;
+  while (frames <= _sampleRate * 0.512)
+    frames <<= 1;
+
+  _delayLine.resize(frames * 2);
+  _delayLineMask = frames - 1;
+
+  _clear();
+}
+
+
+Reverb::~Reverb()
+{}
+
+
+void Reverb::_clear(void)
+{
+  std::fill(_combBuffer.begin(), _combBuffer.end(), 0);
+  std::fill(_allpassBuffer.begin(), _allpassBuffer.end(), 0);
+  std::fill(_delayLine.begin(), _delayLine.end(), 0);
+
+  _combIndex.fill(0);
+  _combFilter.fill(0);
+  _allpassIndex.fill(0);
+
+  _dcIn = 0;
+  _dcOut = 0;
+}
+
+
+// Reverb parameters are only read once per block, and filter coefficients
+// are only recalculated when a parameter has changed
+void Reverb::_update_params(void)
+{
+  uint8_t character = _settings->get_param(PatchParam::ReverbCharacter) & 0x07;
+  uint8_t preLPF = _settings->get_param(PatchParam::ReverbPreLPF) & 0x07;
+  uint8_t time = _settings->get_param(PatchParam::ReverbTime) & 0x7f;
+  uint8_t delayFeedback =
+    _settings->get_param(PatchParam::ReverbDelayFeedback) & 0x7f;
+
+  if (preLPF != _preLPF) {
+    _preLPF = preLPF;
+    _lpFilter.calculate_coefficients(_lpCutoffFreq[_preLPF], 0.707);
+  }
+
+  if (character != _character) {
+    _character = character;
+    _time = 0xff;
+    _delayFeedback = 0xff;
+    _clear();
+  }
+
+  if (time == _time && delayFeedback == _delayFeedback)
+    return;
+
+  _time = time;
+  _delayFeedback = delayFeedback;
+
+  if (_character < _presets.size()) {
+    const Preset &p = _presets[_character];
+    uint32_t spread = 23 * _sampleRate / 44100;
+
+    // TODO: Find the correct reverb time curve. For now reverb time is
+    //       linear with ReverbTime, doubling the preset time at 0x7f.
+    float rt60 = p.time * (time + 1) / 65.0;
+
+    for (int ch = 0; ch < 2; ch++) {
+      for (int c = 0; c < numCombs; c++) {
+	int i = ch * numCombs + c;
+	_combLength[i] = _combTime[c] * p.size * _sampleRate / 1000 +
+	  ch * spread;
+	_combFeedback[i] = std::pow(10.0, -3.0 * _combLength[i] /
+				    (rt60 * _sampleRate));
+	_combIndex[i] %= _combLength[i];
+      }
+    }
+
+    _damp = p.damp;
+
+    // Output is below -120 dB after twice the reverb time
+    double length = 2 * rt60 * _sampleRate;
+    for (int a = 0; a < numAllpass * 2; a++)
+      length += EffectTail::feedback_length(_allpassLength[a], 0.5);
+    _tail.set_length(length);
+
+  } else {
+    // TODO: Verify delay times. ReverbTime is assumed to be 4 ms steps.
+    _delayLength = std::min((uint32_t) ((time + 1) * 0.004 * _sampleRate),
+			    _delayLineMask);
+    _feedback = delayFeedback / 128.0;
+
+    // Panning delay adds one delay line length for the right channel
+    _tail.set_length(EffectTail::feedback_length(_delayLength, _feedback) +
+		     _delayLength);
+  }
+}
+
+
+bool Reverb::process_block(const float *input, float *output, uint32_t frames)
+{
+  if (!_tail.update(input, frames))
+    return false;
+
+  _update_params();
+
+  if (_character < _presets.size())
+    _process_reverb(input, output, frames);
+  else
+    _process_delay(input, output, frames, _character == 7);
+
+  return true;
+}
+
+
+void Reverb::_process_reverb(const float *input, float *output,
+			     uint32_t frames)
+{
+  const float inputGain = 0.1;
+  const float allpassFeedback = 0.5;
+
+  for (uint32_t i = 0; i < frames; i++) {
+    float in = _lpFilter.apply(input[i]) * inputGain;
+
+    _dcOut = in - _dcIn + _dcPole * _dcOut;
+    _dcIn = in;
+    in = _dcOut;
+
+    // Parallel comb filters, first half for left and second half for right
+    float comb[numCombs * 2];
+    for (int c = 0; c < numCombs * 2; c++) {
+      float *buffer = &_combBuffer[c * _combCapacity];
+      float out = buffer[_combIndex[c]];
+
+      _combFilter[c] = out + _damp * (_combFilter[c] - out);
+      buffer[_combIndex[c]] = in + _combFilter[c] * _combFeedback[c];
+
+      if (++_combIndex[c] >= _combLength[c])
+	_combIndex[c] = 0;
+
+      comb[c] = out;
+    }
+
+    float out[2] = { 0, 0 };
+    for (int c = 0; c < numCombs; c++) {
+      out[0] += comb[c];
+      out[1] += comb[numCombs + c];
+    }
+
+    // Series allpass filters for each channel
+    for (int ch = 0; ch < 2; ch++) {
+      for (int a = 0; a < numAllpass; a++) {
+	int j = ch * numAllpass + a;
+	float *buffer = &_allpassBuffer[j * _allpassCapacity];
+	float delayed = buffer[_allpassIndex[j]];
+
+	buffer[_allpassIndex[j]] = out[ch] + delayed * allpassFeedback;
+	out[ch] = delayed - out[ch];
+
+	if (++_allpassIndex[j] >= _allpassLength[j])
+	  _allpassIndex[j] = 0;
+      }
+    }
+
+    output[i * 2] = out[0];
+    output[i * 2 + 1] = out[1];
+  }
+}
+
+
+// Delay feeds back on the same channel, while panning delay alternates the
+// echoes between left and right channel
+void Reverb::_process_delay(const float *input, float *output, uint32_t frames,
+			    bool panning)
+{
+  float *line = _delayLine.data();
+  const uint32_t mask = _delayLineMask;
+
+  for (uint32_t i = 0; i < frames; i++) {
+    float in = _lpFilter.apply(input[i]);
+    uint32_t readIndex = (_writeIndex - _delayLength) & mask;
+
+    float left = line[readIndex * 2];
+    float right = line[readIndex * 2 + 1];
+
+    if (panning) {
+      line[_writeIndex * 2] = in + right * _feedback;
+      line[_writeIndex * 2 + 1] = left;
+    } else {
+      line[_writeIndex * 2] = in + left * _feedback;
+      line[_writeIndex * 2 + 1] = line[_writeIndex * 2];
+    }
+
+    output[i * 2] = left;
+    output[i * 2 + 1] = right;
+
+    _writeIndex = (_writeIndex + 1) & mask;
+  }
+}
+
+}
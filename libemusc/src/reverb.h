@@ -0,0 +1,124 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// System reverb shared by all parts. The Sound Canvas reverb algorithms are
+// unknown, so EmuSC uses a Schroeder reverb with 4 parallel comb filters and
+// 2 series allpass filters per channel for the room, hall and plate types,
+// and a simple feedback delay line for the two delay types.
+
+
+#ifndef __REVERB_H__
+#define __REVERB_H__
+
+
+#include "effect_tail.h"
+#include "lowpass_filter.h"
+#include "settings.h"
+
+#include <array>
+#include <vector>
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+class Reverb
+{
+ public:
+  Reverb(Settings *settings);
+  ~Reverb();
+
+  // Process a block of mono input and write interleaved stereo output.
+  // Returns false without writing any output if the effect is bypassed.
+  bool process_block(const float *input, float *output, uint32_t frames);
+
+
+ private:
+  Reverb();
+
+  static const int numCombs = 4;
+  static const int numAllpass = 2;
+
+  Settings *_settings;
+  uint32_t _sampleRate;
+
+  // Last parameter values, coefficients are only updated on changes
+  uint8_t _character;
+  uint8_t _preLPF;
+  uint8_t _time;
+  uint8_t _delayFeedback;
+
+  LowPassFilter _lpFilter;
+  EffectTail _tail;
+
+  // One-pole DC blocker on the reverb input, since the combs have a DC gain
+  // of 1 / (1 - feedback)
+  float _dcPole;
+  float _dcIn;
+  float _dcOut;
+
+  // Comb and allpass filters for both channels stored as arrays over all
+  // filters, so that each stage is processed in one loop for all filters.
+  // Buffers have fixed capacity and delay lengths are set by the character.
+  uint32_t _combCapacity;
+  std::vector<float> _combBuffer;
+  std::array<uint32_t, numCombs * 2> _combLength;
+  std::array<uint32_t, numCombs * 2> _combIndex;
+  std::array<float, numCombs * 2> _combFeedback;
+  std::array<float, numCombs * 2> _combFilter;  // Damping filter state
+  float _damp;
+
+  uint32_t _allpassCapacity;
+  std::vector<float> _allpassBuffer;
+  std::array<uint32_t, numAllpass * 2> _allpassLength;
+  std::array<uint32_t, numAllpass * 2> _allpassIndex;
+
+  // Interleaved stereo delay line used by the delay types. Size is a power
+  // of 2 so that positions wrap around with a mask.
+  std::vector<float> _delayLine;
+  uint32_t _delayLineMask;
+  uint32_t _delayLength;
+  uint32_t _writeIndex;
+  float _feedback;
+
+  void _update_params(void);
+  void _clear(void);
+
+  void _process_reverb(const float *input, float *output, uint32_t frames);
+  void _process_delay(const float *input, float *output, uint32_t frames,
+		      bool panning);
+
+  // Character presets for room 1 - 3, hall 1 - 2 and plate
+  struct Preset {
+    float size;                // Comb delay scale factor
+    float time;                // Reverb time in seconds at ReverbTime 0x40
+    float damp;                // High frequency damping in feedback loop
+  };
+  static const std::array<Preset, 6> _presets;
+
+  static const std::array<float, numCombs> _combTime;      // ms
+  static const std::array<float, numAllpass> _allpassTime; // ms
+
+  std::array<int, 8> _lpCutoffFreq = { 8000, 5000, 3150, 2000,
+				       1250, 800, 400, 250 };
+};
+
+}
+
+#endif  // __REVERB_H__
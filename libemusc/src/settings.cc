@@ -29,13 +29,14 @@
 namespace EmuSC {
 
 
-Settings::Settings(ControlRom &ctrlRom)
+Settings::Settings(const ControlRom &ctrlRom)
   : _ctrlRom(ctrlRom)
 {
   // TODO: Add SC-55/88 to master settings
   _initialize_system_params();
   _initialize_patch_params();
   _initialize_drumSet_params();
+  _update_channel_parts();
 
   // TODO: Find a proper way to handle calculated controller values
   for (int i = 0; i < 16; i ++)
@@ -224,11 +225,16 @@ void Settings::set_param(enum PatchParam pp, uint8_t value, int8_t part)
     _run_macro_chorus(value);
   } else if (pp == EmuSC::PatchParam::ReverbMacro) {
     _run_macro_reverb(value);
+  } else if (pp == EmuSC::PatchParam::DelayMacro) {
+    _run_macro_delay(value);
 
   // Changes to one of the 6 defined controller groups triggers an update
   // across all controller paramters for that part
   } else if ((int) pp >= 0x1080 && (int) pp <= 0x1086) {
     _update_controller_input(pp, value, part);
+
+  } else if (pp == EmuSC::PatchParam::RxChannel) {
+    _update_channel_parts();
   }
 }
 
@@ -244,6 +250,9 @@ void Settings::set_param(enum PatchParam pp, uint8_t *data, uint8_t size,
     else
       _patchParams[(((int) pp) | (rolandPart << 8)) + i] = data[i];   
   }
+
+  if (_is_rx_channel((int) pp, size))
+    _update_channel_parts();
 }
 
 
@@ -291,6 +300,10 @@ void Settings::set_patch_param(uint16_t address, uint8_t *data, uint8_t size)
     _run_macro_chorus(data[0]);
   } else if (address == 0x130 && size >= 1) {
     _run_macro_reverb(data[0]);
+  } else if (address == 0x150 && size >= 1) {
+    _run_macro_delay(data[0]);
+  } else if (_is_rx_channel(address, size)) {
+    _update_channel_parts();
   }
 }
 
@@ -303,6 +316,9 @@ void Settings::set_patch_param(uint16_t address, uint8_t value, int8_t part)
     _patchParams[address] = value;
 
   _patchParams[(address | (rolandPart << 8))] = value;
+
+  if (_is_rx_channel(address))
+    _update_channel_parts();
 }
 
 
@@ -312,6 +328,9 @@ void Settings::set_param(enum DrumParam dp, uint8_t map, uint8_t key, uint8_t va
     return;
 
   _drumParams[(int) dp | (map << 12) | key] = value;
+
+  if (dp == DrumParam::AssignGroupNumber)
+    _update_assign_group_keys(map);
 }
 
 
@@ -335,6 +354,13 @@ void Settings::set_drum_param(uint16_t address, uint8_t *data, uint8_t size)
 
   for (int i = 0; i < size; i++)
     _drumParams[address + i] = data[i];
+
+  // Drum parameter writes may cover the assign groups of both maps
+  for (int map = 0; map < 2; map++) {
+    int groups = (int) DrumParam::AssignGroupNumber | (map << 12);
+    if (address < groups + 128 && address + size > groups)
+      _update_assign_group_keys(map);
+  }
 }
 
 
@@ -390,6 +416,8 @@ void Settings::_initialize_system_params(enum Mode m)
   // Non-SysEx configuration settings
   _systemParams[(int) SystemParam::SampleRate] = 0;
   _systemParams[(int) SystemParam::Channels] = 2;
+  _systemParams[(int) SystemParam::ControlPeriod] = 16;
+  _systemParams[(int) SystemParam::Interpolation] = 0;
 
   _systemParams[(int) SystemParam::RxSysEx] = 1;
   _systemParams[(int) SystemParam::RxGMOn] = 1;
@@ -434,6 +462,20 @@ void Settings::_initialize_patch_params(enum Mode m)
   _patchParams[(int) PatchParam::ChorusRate] =          0x03;
   _patchParams[(int) PatchParam::ChorusDepth] =         0x13;
   _patchParams[(int) PatchParam::ChorusSendToReverb] =  0x00;
+  _patchParams[(int) PatchParam::ChorusSendToDelay] =   0x00;
+
+  // SC-88 only
+  _patchParams[(int) PatchParam::DelayMacro] =          0x00;
+  _patchParams[(int) PatchParam::DelayPreLPF] =         0x00;
+  _patchParams[(int) PatchParam::DelayTimeCenter] =     0x61;
+  _patchParams[(int) PatchParam::DelayTimeRatioLeft] =  0x01;
+  _patchParams[(int) PatchParam::DelayTimeRatioRight] = 0x01;
+  _patchParams[(int) PatchParam::DelayLevelCenter] =    0x7f;
+  _patchParams[(int) PatchParam::DelayLevelLeft] =      0x00;
+  _patchParams[(int) PatchParam::DelayLevelRight] =     0x00;
+  _patchParams[(int) PatchParam::DelayLevel] =          0x40;
+  _patchParams[(int) PatchParam::DelayFeedback] =       0x50;
+  _patchParams[(int) PatchParam::DelaySendToReverb] =   0x00;
 
   // Remaining paramters are separate for each part
   for (int p = 0; p < 16; p ++) {           // TODO: Support SC-88 with 32 parts
@@ -482,6 +524,7 @@ void Settings::_initialize_patch_params(enum Mode m)
     _patchParams[(int) PatchParam::CC2ControllerNumber| (partAddr << 8)] = 0x11;
     _patchParams[(int) PatchParam::ChorusSendLevel    | (partAddr << 8)] = 0x00;
     _patchParams[(int) PatchParam::ReverbSendLevel    | (partAddr << 8)] = 0x28;
+    _patchParams[(int) PatchParam::DelaySendLevel     | (partAddr << 8)] = 0x00;
     _patchParams[(int) PatchParam::RxBankSelect       | (partAddr << 8)] = 0x01;
 
     _patchParams[(int) PatchParam::PitchFineTune      | (partAddr << 8)] = 0x40;
@@ -809,6 +852,8 @@ int Settings::update_drum_set(uint8_t map, uint8_t bank)
       _ctrlRom.drumSet(index).flags[r] & 0x10;
   }
 
+  _update_assign_group_keys(map);
+
   return index;
 }
 
@@ -829,6 +874,43 @@ void Settings::reset(void)
   _initialize_system_params();
   _initialize_patch_params();
   _initialize_drumSet_params();
+  _update_channel_parts();
+}
+
+
+void Settings::_update_channel_parts(void)
+{
+  _channelParts.fill(0);
+
+  for (int p = 0; p < 16; p ++) {           // TODO: Support SC-88 with 32 parts
+    uint8_t channel = get_param(PatchParam::RxChannel, p);
+    if (channel < 16)                       // 16 = Off
+      _channelParts[channel] |= 1 << p;
+  }
+}
+
+
+void Settings::_update_assign_group_keys(uint8_t map)
+{
+  for (int g = 0; g < 128; g++)
+    _assignGroupKeys[map][g].clear();
+
+  for (int k = 0; k < 128; k++) {
+    uint8_t group = get_param(DrumParam::AssignGroupNumber, map, k);
+    if (group)
+      _assignGroupKeys[map][group & 0x7f].push_back(k);
+  }
+}
+
+
+// Check if a parameter write covers the RxChannel parameter of any part
+bool Settings::_is_rx_channel(int address, int size)
+{
+  for (int i = 0; i < size; i++)
+    if (((address + i) & 0xf0ff) == (int) PatchParam::RxChannel)
+      return true;
+
+  return false;
 }
 
 
@@ -1004,6 +1086,43 @@ void Settings::_run_macro_reverb(uint8_t value)
 }
 
 
+// Macro based on table from SC-8820 owner's manual. TODO: Verify on SC-88
+void Settings::_run_macro_delay(uint8_t value)
+{
+  // Pre-LPF, Time C, Ratio L, Ratio R, Level C, Level L, Level R, Feedback,
+  // Send level to reverb
+  static const uint8_t macros[10][9] = {
+    { 0x00, 0x61, 0x01, 0x01, 0x7f, 0x00, 0x00, 0x50, 0x00 }, // Delay 1
+    { 0x00, 0x6a, 0x01, 0x01, 0x7f, 0x00, 0x00, 0x50, 0x00 }, // Delay 2
+    { 0x00, 0x73, 0x01, 0x01, 0x7f, 0x00, 0x00, 0x48, 0x00 }, // Delay 3
+    { 0x00, 0x53, 0x01, 0x01, 0x7f, 0x40, 0x40, 0x60, 0x00 }, // Delay 4
+    { 0x00, 0x69, 0x0c, 0x18, 0x00, 0x7d, 0x3c, 0x4f, 0x00 }, // Pan Delay 1
+    { 0x00, 0x6d, 0x0c, 0x18, 0x00, 0x7d, 0x3c, 0x55, 0x00 }, // Pan Delay 2
+    { 0x00, 0x73, 0x08, 0x18, 0x00, 0x78, 0x40, 0x4a, 0x00 }, // Pan Delay 3
+    { 0x00, 0x5d, 0x0c, 0x18, 0x00, 0x76, 0x7f, 0x63, 0x00 }, // Pan Delay 4
+    { 0x00, 0x6d, 0x01, 0x01, 0x7f, 0x00, 0x00, 0x50, 0x40 }, // Delay to Rev
+    { 0x00, 0x6e, 0x16, 0x2c, 0x7f, 0x7f, 0x7f, 0x40, 0x00 }  // Pan Repeat
+  };
+
+  if (value >= 10)
+    return;
+
+  const uint8_t *m = macros[value];
+  _patchParams[(int) PatchParam::DelayPreLPF] =         m[0];
+  _patchParams[(int) PatchParam::DelayTimeCenter] =     m[1];
+  _patchParams[(int) PatchParam::DelayTimeRatioLeft] =  m[2];
+  _patchParams[(int) PatchParam::DelayTimeRatioRight] = m[3];
+  _patchParams[(int) PatchParam::DelayLevelCenter] =    m[4];
+  _patchParams[(int) PatchParam::DelayLevelLeft] =      m[5];
+  _patchParams[(int) PatchParam::DelayLevelRight] =     m[6];
+  _patchParams[(int) PatchParam::DelayFeedback] =       m[7];
+  _patchParams[(int) PatchParam::DelaySendToReverb] =   m[8];
+
+  // This param is equal for all macro values
+  _patchParams[(int) PatchParam::DelayLevel] =          0x40;
+}
+
+
 // The SC-55+ have 6 independent controllers that each controls 11 parameters.
 // These parameters are accumulated from each of the controllers. Note that
 // accumulated values are only updated when a controller changes value - and
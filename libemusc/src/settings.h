@@ -28,6 +28,7 @@
 
 #include <array>
 #include <string>
+#include <vector>
 
 
 namespace EmuSC {
@@ -35,7 +36,7 @@ namespace EmuSC {
 class Settings
 {
 public:
-  Settings(ControlRom & ctrlRom);
+  Settings(const ControlRom & ctrlRom);
   ~Settings();
 
   // Sound Canvas Modes
@@ -95,20 +96,41 @@ public:
   void update_pitchBend_factor(int8_t part);
   float get_pitchBend_factor(int8_t part) { return _PBController[part]; }
 
+  // Bitmask of parts listening to a MIDI channel, updated whenever the
+  // RxChannel parameter of a part is changed
+  uint32_t get_channel_parts(uint8_t channel)
+  { return _channelParts[channel & 0x0f]; }
+
+  // Keys in a drum map belonging to an exclusive class (assign group),
+  // updated whenever the AssignGroupNumber parameter of a key is changed
+  const std::vector<uint8_t> &get_assign_group_keys(uint8_t map, uint8_t group)
+  { return _assignGroupKeys[map & 0x01][group & 0x7f]; }
+
   static int8_t convert_to_roland_part_id(int8_t part);
   static int8_t convert_from_roland_part_id(int8_t part);
 
+  // Maximum number of frames processed internally in one block. Longer render
+  // requests are split into blocks of this size.
+  static const uint32_t maxBlockSize = 64;
+
 private:
   std::array<uint8_t, 0x0100> _systemParams;  // Both SysEx and non-SysEx data
   std::array<uint8_t, 0x4000> _patchParams;
   std::array<uint8_t, 0x2000> _drumParams;
 
-  ControlRom &_ctrlRom;
+  const ControlRom &_ctrlRom;
+
+  std::array<uint32_t, 16> _channelParts;     // MIDI channel -> part mask
+  std::array<std::array<std::vector<uint8_t>, 128>, 2> _assignGroupKeys;
 
   void _initialize_system_params(enum Mode = Mode::GS);
   void _initialize_patch_params(enum Mode = Mode::GS);
   void _initialize_drumSet_params();
 
+  void _update_channel_parts(void);
+  bool _is_rx_channel(int address, int size = 1);
+  void _update_assign_group_keys(uint8_t map);
+
   // BE / LE conversion
   inline bool _le_native(void) { uint16_t n = 1; return (*(uint8_t *) & n); }
   uint8_t  _to_native_endian_nib16(uint8_t *ptr);
@@ -119,6 +141,7 @@ private:
   // Macros for certain settings
   void _run_macro_chorus(uint8_t value);
   void _run_macro_reverb(uint8_t value);
+  void _run_macro_delay(uint8_t value);
 
   // Update accumulated controller inputs
   void _update_controller_input(enum PatchParam pp, uint8_t value, int8_t part);
@@ -18,8 +18,15 @@
 
 
 #include "synth.h"
+#include "chorus.h"
+#include "delay.h"
+#include "midi_event_queue.h"
+#include "note_pool.h"
 #include "part.h"
+#include "resampler.h"
+#include "reverb.h"
 #include "settings.h"
+#include "thread_pool.h"
 
 #include <cstring>
 #include <sys/stat.h>
@@ -32,19 +39,50 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 
 #include "config.h"
 
 
 namespace EmuSC {
 
-Synth::Synth(ControlRom &controlRom, PcmRom &pcmRom, SoundMap map)
+Synth::Synth(const ControlRom &controlRom, const PcmRom &pcmRom,
+	     SoundMap map)
   : _sampleRate(0),
     _channels(0),
+    _controlPeriod(16),
+    _interpolation(Interpolation::Linear),
+    _resampler(NULL),
+    _resampleQuality(ResampleQuality::Medium),
+    _framePosition(0),
+    _outputPosition(0),
+    _notePool(NULL),
+    _threadPool(NULL),
+    _renderPartFrames(0),
+    _chorus(NULL),
+    _reverb(NULL),
+    _delay(NULL),
     _ctrlRom(controlRom),
     _pcmRom(pcmRom)
 {
   _settings = new Settings(controlRom);
+  _midiQueue = new MidiEventQueue();
+
+  // Each part buffer has stereo output followed by mono chorus, reverb and
+  // delay sends
+  _renderPartJob = [this](int i) {
+    float *out = &_partBuffers[i * Settings::maxBlockSize * 5];
+    float *chorusSend = out + Settings::maxBlockSize * 2;
+    float *reverbSend = out + Settings::maxBlockSize * 3;
+    float *delaySend = out + Settings::maxBlockSize * 4;
+    std::fill(out, out + _renderPartFrames * 2, 0);
+    std::fill(chorusSend, chorusSend + _renderPartFrames, 0);
+    std::fill(reverbSend, reverbSend + _renderPartFrames, 0);
+    std::fill(delaySend, delaySend + _renderPartFrames, 0);
+
+    _parts[i].get_next_samples(out, chorusSend, reverbSend, delaySend,
+			       _renderPartFrames);
+  };
 
   _parts.reserve(16);
 
@@ -62,15 +100,40 @@ Synth::Synth(ControlRom &controlRom, PcmRom &pcmRom, SoundMap map)
 
 Synth::~Synth()
 {
+  delete _threadPool;
+  delete _resampler;
   _parts.clear();
+  delete _chorus;
+  delete _reverb;
+  delete _delay;
+  delete _notePool;
+  delete _midiQueue;
   delete _settings;
 }
 
 
+// All notes are allocated up front from a shared pool. The pool is sized to
+// the voice limit in _steal_voices() plus room for one extra note per part.
 void Synth::_init_parts(void)
 {
+  _parts.clear();
+
+  delete _notePool;
+  _notePool = new NotePool(_ctrlRom.max_polyphony() * 2 + 16);
+
   for (int i = 0; i < 16; i++)
-    _parts.emplace_back(i, _settings, _ctrlRom, _pcmRom);
+    _parts.emplace_back(i, _settings, _ctrlRom, _pcmRom, _notePool);
+
+  _partBuffers.resize(_parts.size() * Settings::maxBlockSize * 5);
+
+  delete _chorus;
+  _chorus = new Chorus(_settings);
+  delete _reverb;
+  _reverb = new Reverb(_settings);
+  delete _delay;
+  _delay = NULL;
+  if (_ctrlRom.generation() >= ControlRom::SynthGen::SC88)
+    _delay = new Delay(_settings);
 }
 
 
@@ -80,6 +143,13 @@ void Synth::reset(SoundMap sm, bool resetParts)
     for (auto &p : _parts) p.reset();   //? TODO: CLEAN UP
 
   _settings->reset();
+
+  // Audio format is not part of the GS reset
+  _settings->set_param_uint32(SystemParam::SampleRate, engineSampleRate);
+  _settings->set_param(SystemParam::Channels, _channels);
+  _settings->set_param(SystemParam::ControlPeriod, _controlPeriod);
+  _settings->set_param(SystemParam::Interpolation, (uint8_t) _interpolation);
+
   if (sm == SoundMap::GS_GM) {
     _settings->set_gm_mode();
   } else if (sm == SoundMap::MT32) {
@@ -112,21 +182,73 @@ void Synth::unmute_parts(std::vector<uint8_t> mutePartsList)
 }
 
 
+// Call function for each part listening to the MIDI channel, in part order.
+// Uses the channel to part routing table maintained by Settings.
+template <class F>
+void Synth::_for_each_part(uint8_t midiChannel, F function)
+{
+  uint32_t partMask = _settings->get_channel_parts(midiChannel);
+
+  for (unsigned int i = 0; partMask && i < _parts.size(); i++, partMask >>= 1)
+    if (partMask & 1)
+      function(_parts[i]);
+}
+
+
 void Synth::_add_note(uint8_t midiChannel, uint8_t key, uint8_t velocity)
 {
-  int partialsUsed = 0;
-  for (auto &p: _parts)
-    partialsUsed += p.get_num_partials();
+  _for_each_part(midiChannel, [&](Part &p) {
+    uint64_t serial = _notePool->next_serial();
+    if (p.add_note(key, velocity))
+      _steal_voices(p, serial);
+  });
+}
+
 
-  // TODO: Prioritize parts / MIDI channels based on info in owners manual
+// Keep the number of partials within the voice limit by stealing notes
+// started before the new note (serial). Following the SC-55 owner's manual,
+// notes are only taken from parts using more voices than their Voice Reserve.
+// Released notes go first, then the quietest notes by TVA level, and the
+// oldest notes if levels are equal. If no note can be stolen the new note is
+// removed and counted as dropped.
+void Synth::_steal_voices(Part &part, uint64_t serial)
+{
   // FIXME: Reduce voice count when volume envelope is corrected!
-  if (partialsUsed > _ctrlRom.max_polyphony() * 2)
-    std::cout << "EmuSC: New note on ignored due to voice limit"
-	      << std::endl;
-  else
-    for (auto &p: _parts)
-      if (p.midi_channel() == midiChannel)
-	p.add_note(key, velocity);
+  const int maxPartials = _ctrlRom.max_polyphony() * 2;
+
+  while (_notePool->partials_used() > maxPartials) {
+    Part *victimPart = NULL;
+    Note *victim = NULL;
+    float victimLevel = 0;
+
+    for (auto &p: _parts) {
+      if (p.get_num_partials() <= p.voice_reserve() * 2)
+	continue;
+
+      Note *n = p.steal_candidate(serial);
+      if (!n)
+	continue;
+
+      float level = n->level();
+      if (!victim ||
+	  (n->released() && !victim->released()) ||
+	  (n->released() == victim->released() &&
+	   (level < victimLevel ||
+	    (level == victimLevel && n->serial() < victim->serial())))) {
+	victimLevel = level;
+	victim = n;
+	victimPart = &p;
+      }
+    }
+
+    if (!victim) {
+      part.delete_last_note();
+      _notePool->count_dropped();
+      return;
+    }
+
+    victimPart->delete_note(victim);
+  }
 }
 
 /* Not used -> PcmRom as part of sample dump to disk
@@ -176,82 +298,105 @@ int Synth::_export_sample_24(std::vector<int32_t> &sampleSet,
 */
 
 
-void Synth::midi_input(uint8_t status, uint8_t data1, uint8_t data2)
+void Synth::midi_input(uint8_t status, uint8_t data1, uint8_t data2,
+		       uint64_t timestamp)
 {
-  uint8_t channel = status & 0x0f;
+  uint8_t event[3] = { status, data1, data2 };
+
+  if (!_midiQueue->push(event, 3, _to_engine_frames(timestamp)))
+    std::cerr << "libEmuSC: MIDI event queue is full. Event discarded."
+	      << std::endl;
+}
+
 
-  midiMutex.lock();
+uint32_t Synth::notes_dropped(void)
+{
+  return _notePool->notes_dropped();
+}
+
+
+uint64_t Synth::frame_position(void)
+{
+  uint64_t frames = _outputPosition.load(std::memory_order_relaxed);
+  if (!_sampleRate)
+    return frames;
+
+  return frames * _sampleRate / engineSampleRate;
+}
+
+
+uint32_t Synth::render_lookahead(void)
+{
+  if (!_resampler)
+    return 0;
+
+  uint64_t engineFrames = _resampler->max_lookahead(Settings::maxBlockSize);
+  return (engineFrames * _sampleRate + engineSampleRate - 1) /
+    engineSampleRate + 1;
+}
+
+
+// Apply MIDI channel message. Only called from the audio render thread.
+void Synth::_process_midi_event(uint8_t status, uint8_t data1, uint8_t data2)
+{
+  uint8_t channel = status & 0x0f;
 
   switch (status & 0xf0)
     {
     case midi_NoteOff:
-      for (auto &p: _parts)
-	if (p.midi_channel() == channel)
-	  p.stop_note(data1);
+      _for_each_part(channel, [&](Part &p) { p.stop_note(data1); });
       break;
 
     case midi_NoteOn:
-      if (!data2) {                   // Note On with velocity = 0 => Note Off
-	for (auto &p: _parts)
-	  if (p.midi_channel() == channel)
-	    p.stop_note(data1);
-      } else {
+      if (!data2)                     // Note On with velocity = 0 => Note Off
+	_for_each_part(channel, [&](Part &p) { p.stop_note(data1); });
+      else
 	_add_note(channel, data1, data2);
-      }
       break;
 
     case midi_PolyKeyPressure:
-      for (auto &p: _parts) {
-	if (p.midi_channel() == channel)
-	  p.poly_key_pressure(data1, data2);
-      }
+      _for_each_part(channel, [&](Part &p) {
+	p.poly_key_pressure(data1, data2);
+      });
       break;
 
     case midi_CtrlChange:
-      for (auto &p: _parts) {
-	if (p.midi_channel() == channel) {
-	  if (p.control_change(data1, data2)) {
-	    for (const auto &cb : _partMidiModCallbacks)
-	      cb(p.id());
-	  }
+      _for_each_part(channel, [&](Part &p) {
+	if (p.control_change(data1, data2)) {
+	  for (const auto &cb : _partMidiModCallbacks)
+	    cb(p.id());
 	}
-      }
+      });
       break;
 
     case midi_PrgChange:
-      for (auto &p : _parts)
-	if (p.midi_channel() == channel) {
-	  p.set_program(data1);
+      _for_each_part(channel, [&](Part &p) {
+	p.set_program(data1);
 
-	  for (const auto &cb : _partMidiModCallbacks)
-	    cb(p.id());
-	}
+	for (const auto &cb : _partMidiModCallbacks)
+	  cb(p.id());
+      });
       break;
 
     case midi_ChPressure:
-      for (auto &p: _parts) {
-	if (p.midi_channel() == channel)
-	  p.channel_pressure(data1);
-      }
+      _for_each_part(channel, [&](Part &p) { p.channel_pressure(data1); });
       break;
 
     case midi_PitchBend:
-      for (auto &p: _parts) {
-	if (p.midi_channel() == channel)
-	  p.pitch_bend_change(data1, data2);
-      }
+      _for_each_part(channel, [&](Part &p) {
+	p.pitch_bend_change(data1, data2);
+      });
       break;
 
     default:
       std::cout << "EmuSC MIDI: Unknown event received" << std::endl;
       break;
     }
-
-  midiMutex.unlock();
 }
 
 
-void Synth::midi_input_sysex(uint8_t *data, uint16_t length)
+void Synth::midi_input_sysex(uint8_t *data, uint16_t length,
+			     uint64_t timestamp)
 {
   // First check if SysEx messages has been disabled
   if (!_settings->get_param(SystemParam::RxSysEx))
@@ -281,11 +426,14 @@ void Synth::midi_input_sysex(uint8_t *data, uint16_t length)
     return;
   }
 
+  // Format message separately to not change std::cout state, which is shared
+  // with other threads and Synth instances
   if (1) {
-    std::cout << "libEmuSC: Valid SysEx  message received: ";
+    std::ostringstream msg;
+    msg << "libEmuSC: Valid SysEx  message received: ";
     for (int i = 0; i < length; i ++)
-      std::cout << std::hex << (int) data[i] << " " << std::flush;
-    std::cout << std::endl;
+      msg << std::hex << (int) data[i] << " ";
+    std::cout << msg.str() << std::endl;
   }
 
   if (data[4] == 0x11) {
@@ -293,82 +441,265 @@ void Synth::midi_input_sysex(uint8_t *data, uint16_t length)
     return;
   }
 
-  midiMutex.lock();
-
   // Request data 1 (RQ1)
 //  if (data[4] == 0x11)
 //  _midi_input_sysex_RQ1(&data[5], length - 5 - 2); // Add reply data buffer
 
-  // Data set 1 (DT1)
-  if (data[4] == 0x12)
-    _midi_input_sysex_DT1(data[3], &data[5], length - 5 - 2);
-
-  midiMutex.unlock();
+  // Data set 1 (DT1) is queued and applied by the render thread. Longer
+  // messages than the queue holds write more data than any supported
+  // parameter block and would be discarded by the DT1 handler anyway.
+  if (data[4] == 0x12) {
+    if (length > MidiEventQueue::maxEventSize)
+      std::cerr << "libEmuSC: Roland SysEx message has unsupported data "
+		<< "length. Message discarded." << std::endl;
+    else if (!_midiQueue->push(data, length, _to_engine_frames(timestamp)))
+      std::cerr << "libEmuSC: MIDI event queue is full. Message discarded."
+		<< std::endl;
+  }
 }
 
 
-int Synth::get_next_sample(int16_t *sampleOut)
+int Synth::render(float *out, size_t frames)
 {
-  float partSample[2];
-  float partSysEffect[2];
-  float accumulatedSample[2] = { 0, 0 };
-  float accumulatedSysEffect[2] = { 0, 0 };
+  float buffer[Settings::maxBlockSize * 2];
+
+  // Split request into blocks of maximum internal block size
+  while (frames > 0) {
+    uint32_t blockSize = (frames < Settings::maxBlockSize) ?
+      frames : Settings::maxBlockSize;
 
-  // Write silence
-  for (int i = 0; i < _channels; i++) {
-    sampleOut[i] = 0;
+    _render_output(buffer, blockSize);
+
+    for (uint32_t f = 0; f < blockSize; f++)
+      for (int c = 0; c < _channels; c++)
+	*out++ = buffer[f * 2 + c];
+
+    frames -= blockSize;
   }
 
-  midiMutex.lock();
+  return 0;
+}
+
 
-  // Iterate all parts and ask for next sample
-  for (auto &p : _parts) {
-    partSample[0] = partSample[1] = 0;
-    partSysEffect[0] = partSysEffect[1] = 0;
-    p.get_next_sample(partSample, partSysEffect);
+int Synth::render(float *left, float *right, size_t frames)
+{
+  float buffer[Settings::maxBlockSize * 2];
+
+  // Split request into blocks of maximum internal block size
+  while (frames > 0) {
+    uint32_t blockSize = (frames < Settings::maxBlockSize) ?
+      frames : Settings::maxBlockSize;
 
-    accumulatedSample[0] += partSample[0];
-    accumulatedSample[1] += partSample[1];
+    _render_output(buffer, blockSize);
 
-    accumulatedSysEffect[0] += partSysEffect[0];
-    accumulatedSysEffect[1] += partSysEffect[1];
+    for (uint32_t f = 0; f < blockSize; f++) {
+      *left++ = buffer[f * 2];
+      *right++ = buffer[f * 2 + 1];
+    }
+
+    frames -= blockSize;
   }
 
-  // Finished working MIDI data
-  midiMutex.unlock();
+  return 0;
+}
 
-  // Apply sample effects that applies to "system" level (all parts & notes)
-  accumulatedSample[0] += accumulatedSysEffect[0];
-  accumulatedSample[1] += accumulatedSysEffect[1];
 
-  // Apply pan
-  uint8_t pan = _settings->get_param(SystemParam::Pan);
-  if (pan > 64)
-    accumulatedSample[0] *= 1.0 - (pan - 64) / 63.0;
-  else if (pan < 64)
-    accumulatedSample[1] *= ((pan - 1) / 64.0);
+int Synth::render(int16_t *out, size_t frames)
+{
+  float buffer[Settings::maxBlockSize * 2];
+  bool clipped = false;
+
+  // Split request into blocks of maximum internal block size
+  while (frames > 0) {
+    uint32_t blockSize = (frames < Settings::maxBlockSize) ?
+      frames : Settings::maxBlockSize;
+
+    _render_output(buffer, blockSize);
+
+    // Convert to 16 bit and saturate samples outside full scale
+    for (uint32_t f = 0; f < blockSize; f++) {
+      for (int c = 0; c < _channels; c++) {
+	float sample = buffer[f * 2 + c];
+
+	if (sample > 1 || sample < -1) {
+	  sample = (sample > 1) ? 1 : -1;
+	  clipped = true;
+	}
 
-  // Apply master volume conversion
-  uint8_t volume = _settings->get_param(SystemParam::Volume);
+	*out++ = (int16_t) (sample * 32767);
+      }
+    }
 
-  accumulatedSample[0] *= (volume / 127.0);
-  accumulatedSample[1] *= (volume / 127.0);
+    frames -= blockSize;
+  }
 
   // Check if sound is too loud => clipping
-  if (accumulatedSample[0] > 1 || accumulatedSample[0] < -1) {
+  if (clipped)
     std::cout << "EmuSC: Warning - audio clipped (too loud)" << std::endl;
-    accumulatedSample[0] = (accumulatedSample[0] > 1) ? 1 : -1;
+
+  return 0;
+}
+
+
+int Synth::get_next_sample(int16_t *sampleOut)
+{
+  return render(sampleOut, 1);
+}
+
+
+// Render a number of frames at the output sample rate. Number of frames must
+// be <= maxBlockSize.
+void Synth::_render_output(float *out, uint32_t frames)
+{
+  if (!_resampler) {
+    _render_block(out, frames);
+    _outputPosition.store(_framePosition.load(std::memory_order_relaxed),
+			  std::memory_order_relaxed);
+    return;
   }
-  if (accumulatedSample[1] > 1 || accumulatedSample[1] < -1) {
-    std::cout << "EmuSC: Warning - audio clipped (too loud)" << std::endl;
-    accumulatedSample[1] = (accumulatedSample[1] > 1) ? 1 : -1;
+
+  float buffer[Settings::maxBlockSize * 2];
+
+  // Feed resampler with engine blocks until request is filled
+  uint32_t n = 0;
+  while ((n += _resampler->process(&out[n * 2], frames - n)) < frames) {
+    _render_block(buffer, Settings::maxBlockSize);
+    _resampler->push(buffer, Settings::maxBlockSize);
   }
 
-  // Convert to 16 bit and update sample data in audio output driver
-  for (int c = 0; c < _channels; c++)
-    sampleOut[c] += (int16_t) (accumulatedSample[c] * 0xffff);
+  // The engine runs ahead of the output by the resampler lookahead
+  uint64_t position = _framePosition.load(std::memory_order_relaxed);
+  uint32_t lookahead = _resampler->lookahead();
+  _outputPosition.store((position > lookahead) ? position - lookahead : 0,
+			std::memory_order_relaxed);
+}
 
-  return 0;
+
+// Render one block of interleaved stereo frames with all parts, system effects
+// and master settings applied. Number of frames must be <= maxBlockSize.
+// Output is not clipped.
+void Synth::_render_block(float *out, uint32_t frames)
+{
+  float accumulatedSample[Settings::maxBlockSize * 2] = { 0 };
+  float chorusSend[Settings::maxBlockSize] = { 0 };
+  float reverbSend[Settings::maxBlockSize] = { 0 };
+  float delaySend[Settings::maxBlockSize] = { 0 };
+
+  uint64_t blockStart = _framePosition.load(std::memory_order_relaxed);
+  uint32_t pos = 0;
+
+  // Split block at MIDI event timestamps so that each event is applied at
+  // the exact frame it was scheduled for
+  while (pos < frames) {
+    uint32_t end = frames;
+
+    MidiEventQueue::Event *e;
+    while ((e = _midiQueue->front()) != NULL) {
+      if (e->timestamp > blockStart + pos) {
+	if (e->timestamp < blockStart + frames)
+	  end = e->timestamp - blockStart;
+	break;
+      }
+
+      if (e->data[0] == 0xf0)
+	_midi_input_sysex_DT1(e->data[3], &e->data[5], e->length - 5 - 2);
+      else
+	_process_midi_event(e->data[0], e->data[1], e->data[2]);
+
+      _midiQueue->pop();
+    }
+
+    // Render all parts up to next event, possibly in parallel
+    _renderPartFrames = end - pos;
+    if (_threadPool)
+      _threadPool->run(_renderPartJob, _parts.size());
+    else
+      for (unsigned int i = 0; i < _parts.size(); i++)
+	_renderPartJob(i);
+
+    // Mix parts in fixed order so that output does not depend on threads
+    for (unsigned int i = 0; i < _parts.size(); i++) {
+      float *out = &_partBuffers[i * Settings::maxBlockSize * 5];
+      float *partChorusSend = out + Settings::maxBlockSize * 2;
+      float *partReverbSend = out + Settings::maxBlockSize * 3;
+      float *partDelaySend = out + Settings::maxBlockSize * 4;
+
+      for (uint32_t j = 0; j < _renderPartFrames * 2; j++)
+	accumulatedSample[pos * 2 + j] += out[j];
+      for (uint32_t j = 0; j < _renderPartFrames; j++) {
+	chorusSend[pos + j] += partChorusSend[j];
+	reverbSend[pos + j] += partReverbSend[j];
+	delaySend[pos + j] += partDelaySend[j];
+      }
+    }
+
+    pos = end;
+  }
+
+  _framePosition.store(blockStart + frames, std::memory_order_relaxed);
+
+  // System effects are processed once for the whole block, and are bypassed
+  // when both their input and tail are silent
+  float chorusOut[Settings::maxBlockSize * 2];
+  if (_chorus && _chorus->process_block(chorusSend, chorusOut, frames)) {
+    float chorusLevel = _settings->get_param(PatchParam::ChorusLevel) / 127.0;
+    for (uint32_t i = 0; i < frames * 2; i++)
+      accumulatedSample[i] += chorusOut[i] * chorusLevel;
+
+    // Chorus output can also be sent to reverb
+    float toReverb =
+      _settings->get_param(PatchParam::ChorusSendToReverb) / 127.0 *
+      chorusLevel;
+    if (toReverb > 0)
+      for (uint32_t i = 0; i < frames; i++)
+	reverbSend[i] += (chorusOut[i * 2] + chorusOut[i * 2 + 1]) / 2 *
+	  toReverb;
+
+    float toDelay =
+      _settings->get_param(PatchParam::ChorusSendToDelay) / 127.0 *
+      chorusLevel;
+    if (_delay && toDelay > 0)
+      for (uint32_t i = 0; i < frames; i++)
+	delaySend[i] += (chorusOut[i * 2] + chorusOut[i * 2 + 1]) / 2 *
+	  toDelay;
+  }
+
+  float delayOut[Settings::maxBlockSize * 2];
+  if (_delay && _delay->process_block(delaySend, delayOut, frames)) {
+    float delayLevel = _settings->get_param(PatchParam::DelayLevel) / 127.0;
+    for (uint32_t i = 0; i < frames * 2; i++)
+      accumulatedSample[i] += delayOut[i] * delayLevel;
+
+    // Delay output can also be sent to reverb
+    float toReverb =
+      _settings->get_param(PatchParam::DelaySendToReverb) / 127.0 *
+      delayLevel;
+    if (toReverb > 0)
+      for (uint32_t i = 0; i < frames; i++)
+	reverbSend[i] += (delayOut[i * 2] + delayOut[i * 2 + 1]) / 2 *
+	  toReverb;
+  }
+
+  float reverbOut[Settings::maxBlockSize * 2];
+  if (_reverb && _reverb->process_block(reverbSend, reverbOut, frames)) {
+    float reverbLevel = _settings->get_param(PatchParam::ReverbLevel) / 127.0;
+    for (uint32_t i = 0; i < frames * 2; i++)
+      accumulatedSample[i] += reverbOut[i] * reverbLevel;
+  }
+
+  // Apply pan
+  uint8_t pan = _settings->get_param(SystemParam::Pan);
+  float panLeft = (pan > 64) ? 1.0 - (pan - 64) / 63.0 : 1;
+  float panRight = (pan < 64) ? ((pan - 1) / 64.0) : 1;
+
+  // Apply master volume conversion. Internal mix level 0.5 is full scale.
+  float volume = _settings->get_param(SystemParam::Volume) / 127.0 * 2;
+
+  // Apply master pan and volume
+  for (uint32_t i = 0; i < frames * 2; i += 2) {
+    out[i] = accumulatedSample[i] * panLeft * volume;
+    out[i + 1] = accumulatedSample[i + 1] * panRight * volume;
+  }
 }
 
 
@@ -384,18 +715,85 @@ std::array<float, 16> Synth::get_parts_last_peak_sample(void)
 }
 
 
+// The voice engine always runs at the native 32 kHz sample rate of the Sound
+// Canvas. Output is resampled to the audio device sample rate if different.
 void Synth::set_audio_format(uint32_t sampleRate, uint8_t channels)
 {
-  _settings->set_param_uint32(SystemParam::SampleRate, sampleRate);
+  _settings->set_param_uint32(SystemParam::SampleRate, engineSampleRate);
   _settings->set_param(SystemParam::Channels, channels);
 
   _sampleRate = sampleRate;
   _channels = channels;
 
+  _init_resampler();
   _init_parts();
 }
 
 
+void Synth::set_resample_quality(enum ResampleQuality quality)
+{
+  _resampleQuality = quality;
+
+  if (_resampler)
+    _init_resampler();
+}
+
+
+void Synth::_init_resampler(void)
+{
+  delete _resampler;
+  _resampler = NULL;
+
+  if (!_sampleRate || _sampleRate == engineSampleRate)
+    return;
+
+  Resampler::Quality q;
+  switch (_resampleQuality)
+    {
+    case ResampleQuality::Low:    q = Resampler::Quality::Low;    break;
+    case ResampleQuality::High:   q = Resampler::Quality::High;   break;
+    case ResampleQuality::Medium:
+    default:                      q = Resampler::Quality::Medium; break;
+    }
+
+  _resampler = new Resampler(engineSampleRate, _sampleRate, q);
+}
+
+
+// Convert timestamp from output frames to internal engine frames
+uint64_t Synth::_to_engine_frames(uint64_t frames)
+{
+  if (!_sampleRate)
+    return frames;
+
+  return frames * engineSampleRate / _sampleRate;
+}
+
+
+void Synth::set_render_threads(unsigned int threads)
+{
+  delete _threadPool;
+  _threadPool = NULL;
+
+  if (threads > 1)
+    _threadPool = new ThreadPool(threads - 1);
+}
+
+
+void Synth::set_control_period(unsigned int frames)
+{
+  _controlPeriod = std::min(std::max(frames, 1u), 64u);
+  _settings->set_param(SystemParam::ControlPeriod, _controlPeriod);
+}
+
+
+void Synth::set_interpolation(enum Interpolation interpolation)
+{
+  _interpolation = interpolation;
+  _settings->set_param(SystemParam::Interpolation, (uint8_t) _interpolation);
+}
+
+
 std::string Synth::version(void)
 {
   return VERSION;
@@ -26,8 +26,8 @@
 #include "pcm_rom.h"
 
 #include <array>
+#include <atomic>
 #include <functional>
-#include <mutex>
 #include <string>
 #include <vector>
 
@@ -41,11 +41,17 @@
  * Synth class constructor depends on a valid Control Rom and PCM ROM.
  *
  * MIDI events is sent to the emulator via the midi_input() method using the
- * three bytes from raw MIDI events.
+ * three bytes from raw MIDI events. Events are queued without blocking and
+ * applied by the audio render thread at the start of the next block, or at
+ * an exact frame inside a block if a timestamp is given. Timestamps count
+ * frames rendered since the synth was created, see frame_position(). The
+ * part MIDI modification callbacks are run from the render thread.
  * 
- * Audio samples are extracted by calling the get_next_sample() method. This
- * is typically done from a callback function triggered by the OS audio
- * driver when the audio buffer is running low.
+ * Audio samples are extracted by calling the render() method with a buffer
+ * for a number of frames, typically a whole audio period. This is typically
+ * done from a callback function triggered by the OS audio driver when the
+ * audio buffer is running low. Output is interleaved with one sample for
+ * each channel per frame.
  *
  * All settings are configured through the Settings class.
  */
@@ -53,8 +59,15 @@
 
 namespace EmuSC {
 
+class Chorus;
+class Delay;
+class MidiEventQueue;
+class NotePool;
 class Part;
+class Resampler;
+class Reverb;
 class Settings;
+class ThreadPool;
 
 class Synth
 {
@@ -66,20 +79,69 @@ public:
     MT32                      // MT32 arrangement
   };
 
-  Synth(ControlRom &cRom, PcmRom &pRom, SoundMap map = SoundMap::GS);
+  Synth(const ControlRom &cRom, const PcmRom &pRom,
+	SoundMap map = SoundMap::GS);
   ~Synth();
 
   // Add start() and stop()? Won't start if sampleRate is not set?
 
-  void midi_input(uint8_t status, uint8_t data1, uint8_t data2);
-  void midi_input_sysex(uint8_t *data, uint16_t length);
+  void midi_input(uint8_t status, uint8_t data1, uint8_t data2,
+		  uint64_t timestamp = 0);
+  void midi_input_sysex(uint8_t *data, uint16_t length,
+			uint64_t timestamp = 0);
 
+  // Number of output frames rendered so far, used as clock for MIDI
+  // timestamps. Engine frames rendered ahead for the resampler are not
+  // included.
+  uint64_t frame_position(void);
+
+  // Maximum number of output frames the engine renders ahead of the output
+  // when resampling. Events for exact timing must be queued this many frames
+  // before render() reaches them.
+  uint32_t render_lookahead(void);
+
+  // Number of note on events ignored due to the voice limit
+  uint32_t notes_dropped(void);
+
+  // Render a number of frames into an interleaved audio buffer. Float output
+  // is not clipped, full scale is [-1.0, 1.0]. 16 bit output is saturated.
+  int render(float *out, size_t frames);
+  int render(int16_t *out, size_t frames);
+
+  // Render a number of frames into separate left and right channel buffers
+  int render(float *left, float *right, size_t frames);
+
+  // Render a single frame. Deprecated, use render() instead.
   int get_next_sample(int16_t *sample);
   std::array<float, 16> get_parts_last_peak_sample(void);
 
-  // Setting audio properties (default is 44100, 2)
+  // Setting audio properties (default is 44100, 2). Audio is generated at
+  // 32 kHz internally and resampled to the requested sample rate.
   void set_audio_format(uint32_t sampleRate, uint8_t channels);
 
+  enum class ResampleQuality {
+    Low,
+    Medium,                   // Default
+    High
+  };
+  void set_resample_quality(enum ResampleQuality quality);
+
+  // Number of threads used for rendering parts in parallel, including the
+  // calling thread. Default is 1. Output is bit identical for any number of
+  // threads. Must not be called while rendering.
+  void set_render_threads(unsigned int threads);
+
+  // Number of frames between each update of LFOs and envelopes [1 - 64].
+  // Values are ramped linearly between updates. Default is 16, and 1 updates
+  // every frame. Only affects new notes.
+  void set_control_period(unsigned int frames);
+
+  enum class Interpolation {
+    Linear,                   // Default
+    Cubic                     // 4 point, better treble at higher CPU cost
+  };
+  void set_interpolation(enum Interpolation interpolation);
+
   void reset(SoundMap sm, bool resetParts = false);
 
   void panic(void);
@@ -139,16 +201,39 @@ public:
 private:
   Settings *_settings;
   
-  uint32_t _sampleRate;
+  uint32_t _sampleRate;                    // Output sample rate
   uint8_t _channels;
+  uint8_t _controlPeriod;
+  enum Interpolation _interpolation;
 
-  std::mutex midiMutex;
+  // Native sample rate of the Sound Canvas voice engine
+  static const uint32_t engineSampleRate = 32000;
 
+  Resampler *_resampler;
+  enum ResampleQuality _resampleQuality;
+
+  MidiEventQueue *_midiQueue;
+  std::atomic<uint64_t> _framePosition;      // Engine frames rendered
+  std::atomic<uint64_t> _outputPosition;     // Engine frames reached by output
+
+  NotePool *_notePool;        // Preallocated notes shared by all parts
   struct std::vector<Part> _parts;
+
+  // Parallel part rendering. Each part renders to its own buffers that are
+  // mixed in part order afterwards to keep output deterministic.
+  ThreadPool *_threadPool;
+  std::function<void(int)> _renderPartJob;
+  std::vector<float> _partBuffers;
+  uint32_t _renderPartFrames;
+
+  // System effects shared by all parts, fed by the sum of part sends
+  Chorus *_chorus;
+  Reverb *_reverb;
+  Delay *_delay;               // SC-88 and later only
   std::vector<std::function<void(const int)>> _partMidiModCallbacks;
 
-  ControlRom &_ctrlRom;
-  PcmRom &_pcmRom;
+  const ControlRom &_ctrlRom;
+  const PcmRom &_pcmRom;
 
   // MIDI message types
   static const uint8_t midi_NoteOff         = 0x80;
@@ -160,9 +245,17 @@ private:
   static const uint8_t midi_PitchBend       = 0xe0;
 
   void _init_parts(void);
+  void _init_resampler(void);
+  uint64_t _to_engine_frames(uint64_t frames);
+  void _render_output(float *out, uint32_t frames);
+  void _render_block(float *out, uint32_t frames);
 // int _export_sample_24(std::vector<int32_t> &sampleSet, std::string filename);
+  template <class F>
+  void _for_each_part(uint8_t midiChannel, F function);
   void _add_note(uint8_t midiChannel, uint8_t key, uint8_t velocity);
+  void _steal_voices(Part &part, uint64_t serial);
 
+  void _process_midi_event(uint8_t status, uint8_t data1, uint8_t data2);
   void _midi_input_sysex_DT1(uint8_t model, uint8_t *data, uint16_t length);
 
   Synth();
@@ -0,0 +1,107 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "thread_pool.h"
+
+
+namespace EmuSC {
+
+
+ThreadPool::ThreadPool(unsigned int workers)
+  : _batch(0),
+    _activeWorkers(0),
+    _quit(false),
+    _job(NULL),
+    _numJobs(0),
+    _nextJob(0)
+{
+  for (unsigned int i = 0; i < workers; i++)
+    _threads.emplace_back(&ThreadPool::_worker_loop, this);
+}
+
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _quit = true;
+  }
+  _startCond.notify_all();
+
+  for (auto &t : _threads)
+    t.join();
+}
+
+
+void ThreadPool::run(const std::function<void(int)> &job, int numJobs)
+{
+  if (_threads.empty()) {
+    for (int i = 0; i < numJobs; i++)
+      job(i);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _job = &job;
+    _numJobs = numJobs;
+    _nextJob.store(0);
+    _activeWorkers = _threads.size();
+    _batch++;
+  }
+  _startCond.notify_all();
+
+  _run_jobs();
+
+  // Wait for all workers to finish, also those that got no jobs
+  std::unique_lock<std::mutex> lock(_mutex);
+  _doneCond.wait(lock, [this] { return _activeWorkers == 0; });
+}
+
+
+void ThreadPool::_worker_loop(void)
+{
+  uint64_t batch = 0;
+
+  while (1) {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _startCond.wait(lock, [&] { return _quit || _batch != batch; });
+      if (_quit)
+	return;
+      batch = _batch;
+    }
+
+    _run_jobs();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_activeWorkers == 0)
+      _doneCond.notify_one();
+  }
+}
+
+
+void ThreadPool::_run_jobs(void)
+{
+  int i;
+  while ((i = _nextJob.fetch_add(1)) < _numJobs)
+    (*_job)(i);
+}
+
+}
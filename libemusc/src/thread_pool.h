@@ -0,0 +1,76 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Small pool of worker threads used to run a batch of independent jobs, e.g.
+// rendering all parts for one audio block. The calling thread takes part in
+// the work, and jobs are picked from a shared counter so that idle threads
+// grab the next unfinished job.
+
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+
+class ThreadPool
+{
+public:
+  ThreadPool(unsigned int workers);
+  ~ThreadPool();
+
+  // Run job(0) ... job(numJobs - 1) and return when all jobs have finished
+  void run(const std::function<void(int)> &job, int numJobs);
+
+  unsigned int workers(void) { return _threads.size(); }
+
+private:
+  std::vector<std::thread> _threads;
+
+  std::mutex _mutex;
+  std::condition_variable _startCond;
+  std::condition_variable _doneCond;
+
+  uint64_t _batch;              // Incremented for each new batch of jobs
+  unsigned int _activeWorkers;  // Workers not yet finished with current batch
+  bool _quit;
+
+  const std::function<void(int)> *_job;
+  int _numJobs;
+  std::atomic<int> _nextJob;
+
+  void _worker_loop(void);
+  void _run_jobs(void);
+
+  ThreadPool();
+};
+
+}
+
+#endif  // __THREAD_POOL_H__
@@ -18,6 +18,7 @@
 
 
 #include "tva.h"
+#include "fast_math.h"
 
 #include <cmath>
 #include <iostream>
@@ -27,13 +28,12 @@
 namespace EmuSC {
 
 
-TVA::TVA(ControlRom::InstPartial &instPartial, uint8_t key,
+TVA::TVA(const ControlRom::InstPartial &instPartial, uint8_t key,
 	 WaveGenerator *LFO[2], Settings *settings, int8_t partId)
   : _settings(settings),
     _partId(partId),
     _sampleRate(settings->get_param_uint32(SystemParam::SampleRate)),
-    _finished(false),
-    _ahdsr(NULL)
+    _finished(false)
 {
   _LFO1 = LFO[0];
   _LFO2 = LFO[1];
@@ -67,23 +67,19 @@ TVA::TVA(ControlRom::InstPartial &instPartial, uint8_t key,
   phaseShape[3] = (instPartial.TVALenP4 & 0x80) ? 0 : 1;
   phaseShape[4] = (instPartial.TVALenP5 & 0x80) ? 0 : 1;
 
-  std::string id = "TVA (" + std::to_string(instPartial.partialIndex) + ")";
-
-  _ahdsr = new AHDSR(phaseVolume, phaseDuration, phaseShape, key, settings, partId, id);
+  _ahdsr.create(phaseVolume, phaseDuration, phaseShape, key, settings, partId,
+		"TVA");
   _ahdsr->start();
 }
 
 
 TVA::~TVA()
-{
-  if (_ahdsr)
-    delete _ahdsr;
-}
+{}
 
 
 double TVA::_convert_volume(uint8_t volume)
 {
-  double res = (0.1 * pow(2.0, (double)(volume) / 36.7111) - 0.1);
+  double res = (0.1 * FastMath::exp2(volume / 36.7111f) - 0.1);
   if (res > 1)
     res = 1;
   else if (res < 0)
@@ -93,7 +89,9 @@ double TVA::_convert_volume(uint8_t volume)
 }
 
 
-double TVA::get_amplification(void)
+// Calculate amplification for a block of frames. Returns number of frames
+// calculated, which is less than requested if the envelope finished.
+uint32_t TVA::get_amplification(float *amp, uint32_t frames)
 {
   // LFO1
   int LFO1DepthParam = _LFO1DepthPartial +
@@ -107,15 +105,26 @@ double TVA::get_amplification(void)
   float lfo2Depth = LFO2DepthParam * 0.005;         // TODO: Find correct factor
   if (lfo2Depth < 0) lfo2Depth = 0;
 
-  // Tremolo
-  double tremolo = (_LFO1->value() * lfo1Depth) + (_LFO2->value() * lfo2Depth);
+  for (uint32_t i = 0; i < frames; i++) {
+    // Tremolo
+    double tremolo = (_LFO1->value(i) * lfo1Depth) +
+                     (_LFO2->value(i) * lfo2Depth);
 
-  // Volume envelope
-  double volEnvelope = 0;
-  if (_ahdsr)
-    volEnvelope = _ahdsr->get_next_value();
+    // Volume envelope
+    double volEnvelope = 0;
+    if (_ahdsr) {
+      volEnvelope = _ahdsr->get_next_value();
+
+      if (_ahdsr->finished()) {
+	amp[i] = tremolo + volEnvelope;
+	return i + 1;
+      }
+    }
+
+    amp[i] = tremolo + volEnvelope;
+  }
 
-  return tremolo + volEnvelope;
+  return frames;
 }
 
 
@@ -23,6 +23,7 @@
 
 #include "ahdsr.h"
 #include "control_rom.h"
+#include "in_place.h"
 #include "settings.h"
 #include "wave_generator.h"
 
@@ -37,15 +38,18 @@ namespace EmuSC {
 class TVA
 {
 public:
-  TVA(ControlRom::InstPartial &instPartial, uint8_t key, WaveGenerator *LFO[2],
+  TVA(const ControlRom::InstPartial &instPartial, uint8_t key, WaveGenerator *LFO[2],
       Settings *settings, int8_t partId);
   ~TVA();
 
-  double get_amplification();
+  uint32_t get_amplification(float *amp, uint32_t frames);
   void note_off();
 
   bool finished(void);
 
+  // Volume envelope level, used for selecting notes to steal
+  float level(void) { return _ahdsr ? _ahdsr->level() : 0; }
+
 private:
   uint32_t _sampleRate;
 
@@ -53,10 +57,10 @@ private:
   WaveGenerator *_LFO2;
   float _LFO1DepthPartial;
 
-  AHDSR *_ahdsr;
+  InPlace<AHDSR> _ahdsr;
   bool _finished;
   
-  ControlRom::InstPartial *_instPartial;
+  const ControlRom::InstPartial *_instPartial;
 
   Settings *_settings;
   int8_t _partId;
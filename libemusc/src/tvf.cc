@@ -42,20 +42,26 @@
 
 #include "tvf.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <string.h>
 
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
 namespace EmuSC {
 
 
-TVF::TVF(ControlRom::InstPartial &instPartial, uint8_t key,
+const std::vector<float> TVF::_cutoffTable = TVF::_init_cutoff_table();
+
+
+TVF::TVF(const ControlRom::InstPartial &instPartial, uint8_t key,
 	 WaveGenerator *LFO[2], Settings *settings, int8_t partId)
   : _settings(settings),
     _partId(partId),
     _sampleRate(settings->get_param_uint32(SystemParam::SampleRate)),
-    _lpFilter(NULL),
-    _ahdsr(NULL),
     _instPartial(instPartial)
 {
   _LFO1 = LFO[0];
@@ -67,7 +73,7 @@ TVF::TVF(ControlRom::InstPartial &instPartial, uint8_t key,
 
   _LFO1DepthPartial = instPartial.TVFLFODepth & 0x7f;
 
-  _lpFilter = new LowPassFilter(_sampleRate);
+  _lpFilter.create(_sampleRate);
 
   // If TVF envelope phase durations are all 0 we only have a static filter
   // TODO: Verify that this is correct - what to do when P1-5 value != 0?
@@ -94,9 +100,8 @@ TVF::TVF(ControlRom::InstPartial &instPartial, uint8_t key,
   phaseDuration[3] = instPartial.TVFDurP4 & 0x7F;
   phaseDuration[4] = instPartial.TVFDurP5 & 0x7F;
 
-  std::string id = "TVF (" + std::to_string(instPartial.partialIndex) + ")";
-
-  _ahdsr = new AHDSR(phaseLevelInit, phaseLevel, phaseDuration, settings, partId, id);
+  _ahdsr.create(phaseLevelInit, phaseLevel, phaseDuration, settings, partId,
+		"TVF");
   _ahdsr->start();
 
   if (0)
@@ -106,20 +111,18 @@ TVF::TVF(ControlRom::InstPartial &instPartial, uint8_t key,
 
 
 TVF::~TVF()
-{
-  if (_ahdsr)
-    delete _ahdsr;
-
-  if (_lpFilter)
-    delete _lpFilter;
-}
+{}
 
 
-double TVF::apply(double input)
+// Apply filter to a block of samples. Controller inputs are read once per
+// block, while filter envelope and LFOs are updated every frame. The cutoff
+// frequency is looked up in a table, so only the resonance dependent part of
+// the filter coefficients are calculated for each frame.
+void TVF::apply(float *samples, uint32_t frames)
 {
   // Skip filter calculation if filter is disabled for this partial 
   if (_instPartial.TVFBaseFlt == 0)
-    return input;
+    return;
 
   // LFO1
   int lfo1DepthParam = _LFO1DepthPartial +
@@ -136,27 +139,46 @@ double TVF::apply(double input)
   int coFreq = _settings->get_param(PatchParam::TVFCutoffFreq, _partId) - 0x40;
   int tvfRes = _settings->get_param(PatchParam::TVFResonance, _partId) - 0x40;
 
-  int noteFreq;
-  float filterFreq;
-  float filterRes;
-
-  if (_ahdsr)
-    noteFreq = _ahdsr->get_next_value() + coFreq;
-  else
-    noteFreq = _instPartial.TVFBaseFlt + coFreq;
-
-  filterFreq = 440.0 * (double) exp((((float) noteFreq - 69) +
-				     (_LFO1->value() * lfo1Depth) +
-				     (_LFO2->value() * lfo2Depth)) / 12);
-
   // Resonance. NEEDS FIXING
   // resonance = _lpResonance + sRes * 0.02;
-  filterRes = 0.5 + tvfRes * 0.1;            // Logaritmic?
+  float filterRes = 0.5 + tvfRes * 0.1;            // Logaritmic?
   if (filterRes < 0.5) filterRes = 0.5;
+  float invRes = 1 / filterRes;
+
+  const int maxIndex = _cutoffTable.size() - 1;
+
+  for (uint32_t i = 0; i < frames; i++) {
+    int noteFreq;
+
+    if (_ahdsr)
+      noteFreq = _ahdsr->get_next_value() + coFreq;
+    else
+      noteFreq = _instPartial.TVFBaseFlt + coFreq;
+
+    float note = noteFreq + (_LFO1->value(i) * lfo1Depth) +
+                            (_LFO2->value(i) * lfo2Depth);
+    int index = (note - _cutoffTableMin) * _cutoffTableSteps + 0.5f;
+    index = std::min(std::max(index, 0), maxIndex);
+
+    _lpFilter->update_coefficients(_cutoffTable[index], invRes);
+
+    samples[i] = _lpFilter->apply(samples[i]);
+  }
+}
+
+
+// Filter note values n are converted to 440 * exp((n - 69) / 12) Hz
+std::vector<float> TVF::_init_cutoff_table(void)
+{
+  int size = (_cutoffTableMax - _cutoffTableMin) * _cutoffTableSteps + 1;
+  std::vector<float> table(size);
 
-  _lpFilter->calculate_coefficients(filterFreq, filterRes);
+  for (int i = 0; i < size; i++) {
+    double note = _cutoffTableMin + (double) i / _cutoffTableSteps;
+    table[i] = 2 * M_PI * 440.0 * exp((note - 69) / 12);
+  }
 
-  return _lpFilter->apply(input);
+  return table;
 }
 
 
@@ -22,6 +22,7 @@
 
 
 #include "control_rom.h"
+#include "in_place.h"
 #include "lowpass_filter.h"
 #include "ahdsr.h"
 #include "settings.h"
@@ -30,6 +31,7 @@
 #include <stdint.h>
 
 #include <array>
+#include <vector>
 
 
 namespace EmuSC {
@@ -38,11 +40,11 @@ namespace EmuSC {
 class TVF
 {
 public:
-  TVF(ControlRom::InstPartial &instPartial, uint8_t key, WaveGenerator *_LFO[2],
+  TVF(const ControlRom::InstPartial &instPartial, uint8_t key, WaveGenerator *_LFO[2],
       Settings *settings, int8_t partId);
   ~TVF();
 
-  double apply(double input);
+  void apply(float *samples, uint32_t frames);
   void note_off();
 
   inline bool finished(void) { if (_ahdsr) return _ahdsr->finished(); }
@@ -57,14 +59,23 @@ private:
   Settings *_settings;
   int8_t _partId;
 
-  AHDSR *_ahdsr;
-  LowPassFilter *_lpFilter;
+  InPlace<AHDSR> _ahdsr;
+  InPlace<LowPassFilter> _lpFilter;
 
   uint32_t _lpBaseFrequency;
   float _lpResonance;
 
   ControlRom::InstPartial _instPartial;
 
+  // Angular cutoff frequency for filter note values in 1/16 note steps,
+  // shared by all TVFs
+  static const int _cutoffTableMin = -128;
+  static const int _cutoffTableMax = 256;
+  static const int _cutoffTableSteps = 16;
+  static const std::vector<float> _cutoffTable;
+
+  static std::vector<float> _init_cutoff_table(void);
+
   TVF();
 
 };
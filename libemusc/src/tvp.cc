@@ -42,12 +42,11 @@
 namespace EmuSC {
 
 
-TVP::TVP(ControlRom::InstPartial &instPartial, WaveGenerator *LFO[2],
+TVP::TVP(const ControlRom::InstPartial &instPartial, WaveGenerator *LFO[2],
 	 Settings *settings,int8_t partId)
   : _settings(settings),
     _partId(partId),
-    _sampleRate(settings->get_param_uint32(SystemParam::SampleRate)),
-    _ahdsr(NULL)
+    _sampleRate(settings->get_param_uint32(SystemParam::SampleRate))
 {
   _LFO1 = LFO[0];
   _LFO2 = LFO[1];
@@ -77,20 +76,19 @@ TVP::TVP(ControlRom::InstPartial &instPartial, WaveGenerator *LFO[2],
   phaseDuration[3] = instPartial.pitchDurP4 & 0x7F;
   phaseDuration[4] = instPartial.pitchDurP5 & 0x7F;
 
-  std::string id = "TVP (" + std::to_string(instPartial.partialIndex) + ")";
-
-  _ahdsr = new AHDSR(phasePitchInit, phasePitch, phaseDuration, settings, partId, id);
+  _ahdsr.create(phasePitchInit, phasePitch, phaseDuration, settings, partId,
+		"TVP");
   _ahdsr->start();
 }
 
 
 TVP::~TVP()
-{
-  delete _ahdsr;
-}
+{}
 
 
-double TVP::get_pitch()
+// Calculate pitch adjustments for a block of frames. Controller depths are
+// only read once per block, while LFO and envelope are updated every frame.
+void TVP::get_pitch(float *pitch, uint32_t frames)
 {
   // LFO1
   int lfo1DepthParam = _LFO1DepthPartial +
@@ -105,19 +103,21 @@ double TVP::get_pitch()
   float lfo2Depth = lfo2DepthParam * 0.0011;
   if (lfo2Depth < 0) lfo2Depth = 0;
 
-  double vibrato = (1 + (_LFO1->value() * lfo1Depth)) *
-                   (1 + (_LFO2->value() * lfo2Depth));
+  for (uint32_t i = 0; i < frames; i++) {
+    double vibrato = (1 + (_LFO1->value(i) * lfo1Depth)) *
+                     (1 + (_LFO2->value(i) * lfo2Depth));
 
-  // TODO: Delay function -> seconds
-  // sec = 0.5 * exp(_LFODelay * log(10.23 / 0.5) / 50)
+    // TODO: Delay function -> seconds
+    // sec = 0.5 * exp(_LFODelay * log(10.23 / 0.5) / 50)
 
-  // Pitch envelope
-  // Envelope pitch values in ROM seems to be in percent.
-  double pEnv = 1;
-  if (_ahdsr)
-    pEnv += _ahdsr->get_next_value() * 0.01;
+    // Pitch envelope
+    // Envelope pitch values in ROM seems to be in percent.
+    double pEnv = 1;
+    if (_ahdsr)
+      pEnv += _ahdsr->get_next_value() * 0.01;
 
-  return vibrato * pEnv;
+    pitch[i] = vibrato * pEnv;
+  }
 }
 
 
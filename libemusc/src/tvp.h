@@ -23,6 +23,7 @@
 
 #include "ahdsr.h"
 #include "control_rom.h"
+#include "in_place.h"
 #include "settings.h"
 #include "wave_generator.h"
 
@@ -37,11 +38,11 @@ namespace EmuSC {
 class TVP
 {
 public:
-  TVP(ControlRom::InstPartial &instPartial, WaveGenerator *LFO[2],
+  TVP(const ControlRom::InstPartial &instPartial, WaveGenerator *LFO[2],
       Settings *settings, int8_t partId);
   ~TVP();
 
-  double get_pitch(void);
+  void get_pitch(float *pitch, uint32_t frames);
   void note_off();
 
   inline bool finished(void) { if (_ahdsr) return _ahdsr->finished(); }
@@ -53,9 +54,9 @@ private:
   WaveGenerator *_LFO2;
   int _LFO1DepthPartial;
 
-  AHDSR *_ahdsr;
+  InPlace<AHDSR> _ahdsr;
 
-  ControlRom::InstPartial *_instPartial;
+  const ControlRom::InstPartial *_instPartial;
 
   Settings *_settings;
   int8_t _partId;
@@ -0,0 +1,145 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "voice_table.h"
+
+
+namespace EmuSC {
+
+
+VoiceTable::VoiceTable(uint32_t size)
+  : _size(size),
+    _pcm(size, NULL),
+    _last(size, 0),
+    _end(size, 0),
+    _loopLen(size, 0),
+    _interpolation(size, Interpolator::Mode::Linear),
+    _position(size, 0),
+    _frames(size, 0),
+    _ended(size, 0),
+    _volume(size, 0),
+    _velocity(size, 1),
+    _panLeft(size, 1),
+    _panRight(size, 1),
+    _increment(size * Settings::maxBlockSize, 0),
+    _gain(size * Settings::maxBlockSize, 0),
+    _pos(size * Settings::maxBlockSize, 0),
+    _frac(size * Settings::maxBlockSize, 0),
+    _samples(size * Settings::maxBlockSize, 0)
+{}
+
+
+VoiceTable::~VoiceTable()
+{}
+
+
+void VoiceTable::start(uint32_t voice, const struct PcmRom::Samples &samples,
+		       enum Interpolator::Mode interpolation)
+{
+  _pcm[voice] = samples.filtered.data();
+  _last[voice] = samples.filtered.size() - 1;
+  _loopLen[voice] = samples.loopLen;
+  _end[voice] = samples.loopLen ? samples.loopStart + samples.loopLen :
+				  samples.filtered.size() - 1;
+  _interpolation[voice] = interpolation;
+
+  _position[voice] = 0;
+  _frames[voice] = 0;
+  _ended[voice] = 0;
+}
+
+
+// Sample playback. The PCM ROM has the RIAA filtered samples in playback
+// order with loops unrolled, so playback only needs to step the position and
+// interpolate. Positions passing the end of the last loop period are moved
+// back one period, which is the only loop handling needed.
+void VoiceTable::play(const uint32_t *voices, uint32_t numVoices)
+{
+  // Step positions of all voices
+  for (uint32_t v = 0; v < numVoices; v++) {
+    const uint32_t voice = voices[v];
+    const uint32_t offset = voice * Settings::maxBlockSize;
+    const float *increment = &_increment[offset];
+    int32_t *pos = &_pos[offset];
+    float *frac = &_frac[offset];
+    const double end = _end[voice];
+    const double loopLen = _loopLen[voice];
+    const uint32_t frames = _frames[voice];
+
+    double position = _position[voice];
+    uint32_t i;
+    for (i = 0; i < frames; i++) {
+      position += increment[i];
+
+      if (position > end) {
+	if (!loopLen)
+	  break;                                 // Terminate this partial
+
+	while (position > end)
+	  position -= loopLen;
+      }
+
+      pos[i] = (int32_t) position;
+      frac[i] = position - pos[i];
+    }
+
+    _position[voice] = position;
+    if (i < frames) {
+      _frames[voice] = i;
+      _ended[voice] = 1;
+    }
+  }
+
+  // Interpolate and apply static volume for all voices
+  for (uint32_t v = 0; v < numVoices; v++) {
+    const uint32_t voice = voices[v];
+    const uint32_t offset = voice * Settings::maxBlockSize;
+    const uint32_t frames = _frames[voice];
+    float *samples = &_samples[offset];
+
+    Interpolator::process(_interpolation[voice], _pcm[voice], _last[voice],
+			  &_pos[offset], &_frac[offset], samples, frames);
+
+    const double volume = _volume[voice];
+    for (uint32_t i = 0; i < frames; i++)
+      samples[i] *= volume;
+  }
+}
+
+
+void VoiceTable::mix(const uint32_t *voices, uint32_t numVoices, float *out)
+{
+  for (uint32_t v = 0; v < numVoices; v++) {
+    const uint32_t voice = voices[v];
+    const uint32_t offset = voice * Settings::maxBlockSize;
+    const float *samples = &_samples[offset];
+    const float *gain = &_gain[offset];
+    const float panLeft = _panLeft[voice] * _velocity[voice];
+    const float panRight = _panRight[voice] * _velocity[voice];
+    const uint32_t frames = _frames[voice];
+
+    for (uint32_t i = 0; i < frames; i++) {
+      float s = samples[i] * gain[i];
+      out[i * 2] += s * panLeft;
+      out[i * 2 + 1] += s * panRight;
+    }
+  }
+}
+
+}
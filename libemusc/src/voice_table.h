@@ -0,0 +1,124 @@
+/*
+ *  This file is part of libEmuSC, a Sound Canvas emulator library
+ *  Copyright (C) 2022-2024  Håkon Skjelten
+ *
+ *  libEmuSC is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  libEmuSC is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with libEmuSC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Structure of arrays holding the sample playback state for every partial
+// voice in the synth. Voices are indexed by note pool slot, so all voices for
+// all parts live in the same dense arrays. Each block the partials write
+// their pitch and amplitude curves into the control arrays, and the playback
+// loops below only walk these arrays and the PCM data. Playback and mixing
+// run in stages over a list of voices (all voices of a part), so each stage
+// is one tight loop over all voices instead of one call per partial.
+
+
+#ifndef __VOICE_TABLE_H__
+#define __VOICE_TABLE_H__
+
+
+#include "interpolator.h"
+#include "pcm_rom.h"
+#include "settings.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+
+namespace EmuSC {
+
+
+class VoiceTable
+{
+public:
+  VoiceTable(uint32_t size);
+  ~VoiceTable();
+
+  // Prepare voice for playback of a new sample
+  void start(uint32_t voice, const struct PcmRom::Samples &samples,
+	     enum Interpolator::Mode interpolation);
+
+  // Per block control values, maxBlockSize frames for each voice
+  inline float *increment(uint32_t voice)
+  { return &_increment[voice * Settings::maxBlockSize]; }
+  inline float *gain(uint32_t voice)
+  { return &_gain[voice * Settings::maxBlockSize]; }
+
+  // Number of frames to play this block, and sample buffer for the played
+  // frames. The partial filters the samples in place before they are mixed.
+  inline void set_frames(uint32_t voice, uint32_t frames)
+  { _frames[voice] = frames; }
+  inline uint32_t frames(uint32_t voice) { return _frames[voice]; }
+  inline float *samples(uint32_t voice)
+  { return &_samples[voice * Settings::maxBlockSize]; }
+
+  // True when playback has passed the end of a sample without loop
+  inline bool ended(uint32_t voice) { return _ended[voice]; }
+
+  inline void set_volume(uint32_t voice, double volume)
+  { _volume[voice] = volume; }
+  inline void set_velocity(uint32_t voice, float velocity)
+  { _velocity[voice] = velocity; }
+  inline void set_pan(uint32_t voice, float left, float right)
+  { _panLeft[voice] = left; _panRight[voice] = right; }
+
+  // Step sample positions with the increment arrays and read interpolated mono
+  // samples from ROM into the sample buffers of all listed voices. Voices
+  // reaching the end of their sample play fewer frames and are flagged ended.
+  void play(const uint32_t *voices, uint32_t numVoices);
+
+  // Apply gain, velocity and pan to the sample buffers of all listed voices
+  // and add them to interleaved stereo output
+  void mix(const uint32_t *voices, uint32_t numVoices, float *out);
+
+  uint32_t size(void) { return _size; }
+
+private:
+  uint32_t _size;
+
+  // Filtered sample data and loop points
+  std::vector<const float*> _pcm;
+  std::vector<int32_t> _last;          // Last readable sample
+  std::vector<uint32_t> _end;          // Loop end or sample end
+  std::vector<uint32_t> _loopLen;      // 0 = No loop
+  std::vector<Interpolator::Mode> _interpolation;
+
+  // Playback state
+  std::vector<double> _position;       // Sample position from start
+  std::vector<uint32_t> _frames;       // Frames to play in current block
+  std::vector<uint8_t> _ended;
+
+  // Static gain and pan
+  std::vector<double> _volume;
+  std::vector<float> _velocity;
+  std::vector<float> _panLeft;
+  std::vector<float> _panRight;
+
+  // Control values for current block
+  std::vector<float> _increment;
+  std::vector<float> _gain;
+
+  // Sample positions and played samples for current block
+  std::vector<int32_t> _pos;
+  std::vector<float> _frac;
+  std::vector<float> _samples;
+
+  VoiceTable();
+};
+
+}
+
+#endif  // __VOICE_TABLE_H__
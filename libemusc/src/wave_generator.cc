@@ -21,22 +21,19 @@
 // - sine     for vibrato, TVF and TVA
 // - triangle for chorus
 //
-// The exact way the SC-55 generates the wave forms is unknown, but EmuSC is
-// currently using either a simple lookup table or direct calculation.
+// The exact way the SC-55 generates the wave forms is unknown. EmuSC uses a
+// 32 bit phase accumulator that is advanced once per control period, with a
+// lookup table for sine and direct calculation from the phase for triangle.
 
 
 #include "wave_generator.h"
 
 #include <algorithm>
-#include <cmath>
+#include <cstdlib>
 #include <iostream>
 
 #include <stdint.h>
 
-#ifndef M_PI
-    #define M_PI 3.14159265358979323846
-#endif
-
 
 namespace EmuSC {
 
@@ -47,18 +44,21 @@ constexpr std::array<float, 256> WaveGenerator::_sineTable;
 
 
 WaveGenerator::WaveGenerator(enum Waveform waveForm, uint32_t sampleRate,
-			     uint8_t baseFrequency, bool useLUT, bool interpolate)
+			     uint8_t baseFrequency)
   : _waveForm(waveForm),
     _sampleRate(sampleRate),
     _baseFrequency(baseFrequency),
-    _useLUT(useLUT),
-    _interpolate(interpolate),
+    _rate(-1),
     _frequency(0),
     _delay(0),
     _fade(0),
-    _index(0)
+    _fadeMax(0),
+    _phase(0),
+    _phaseInc(0),
+    _currentValue(0),
+    _controlPeriod(1)
 {
-  _sampleFactor = 1.0 / sampleRate;
+  _phaseScale = 4294967296.0 / sampleRate;
 }
 
 
@@ -69,7 +69,21 @@ WaveGenerator::~WaveGenerator()
 void WaveGenerator::update_frequency(int changeRate)
 {
   int newRate = std::min(std::max(_baseFrequency + changeRate, 0), 127);
-  _frequency = newRate / 10.0;
+  if (newRate == _rate)
+    return;
+
+  _rate = newRate;
+  set_frequency(newRate / 10.0);
+}
+
+
+void WaveGenerator::set_frequency(float frequency)
+{
+  if (frequency == _frequency)
+    return;
+
+  _frequency = frequency;
+  _phaseInc = (frequency > 0) ? (uint32_t) (frequency * _phaseScale) : 0;
 }
 
 
@@ -88,63 +102,79 @@ void WaveGenerator::set_fade(int newFade)
 }
 
 
-void WaveGenerator::next(void)
+void WaveGenerator::set_control_period(uint32_t frames)
 {
-  if (_frequency <= 0) {                     // 0 freq => no output
-    _currentValue = 0;
-    return;
-  }
+  _controlPeriod = std::max(frames, (uint32_t) 1);
+}
 
-  if (_delay > 0) {                          // delay > 0 => no output
-    _delay--;
-    _currentValue = 0;
-    return;
-  }
 
-  // Calculate waveform value
-  double LFOValue;
-  if (_waveForm == Waveform::sine) {
-    if (!_useLUT) {
-      _index += (float) _frequency * _sampleFactor;
-      while (_index > 2.0 * M_PI) _index -=  2.0 * M_PI;
-
-      LFOValue = std::sin(2.0 * M_PI * _index);
+void WaveGenerator::set_phase(float phase)
+{
+  _phase = (uint32_t) (phase * 4294967296.0);
+}
 
-    } else {
-      _index += (float) _sineTable.size() * _frequency * _sampleFactor;
 
-      while (_index >= _sineTable.size())
-	_index -= _sineTable.size();
+// LFO values are calculated at control rate and ramped linearly between
+void WaveGenerator::next(void)
+{
+  if (_ramp.update_needed())
+    _ramp.set_target(_advance(_controlPeriod), _controlPeriod);
 
-      if (!_interpolate) {
-	LFOValue = _sineTable[(int) _index];
+  _currentValue = _ramp.next();
+}
 
-      } else {
-	int nextIndex = (int) _index + 1;
-	if (nextIndex >= _sineTable.size())
-	  nextIndex = 0;
 
-	float fractionNext = _index - ((int) _index);
-	float fractionPrev = 1.0 - fractionNext;
+// Move LFO forward a number of frames and return the new value
+double WaveGenerator::_advance(uint32_t frames)
+{
+  if (_phaseInc == 0)                        // 0 freq => no output
+    return 0;
 
-	LFOValue = fractionPrev * _sineTable[(int) _index] +
-	           fractionNext * _sineTable[nextIndex];
-      }
+  if (_delay > 0) {                          // delay > 0 => no output
+    if (_delay >= (int) frames) {
+      _delay -= frames;
+      return 0;
     }
 
-  } else {     // TODO: Triangle waveform
+    frames -= _delay;
+    _delay = 0;
+  }
 
+  // Phase wraps around by unsigned overflow
+  _phase += _phaseInc * frames;
 
+  // Calculate waveform value
+  float LFOValue;
+  if (_waveForm == Waveform::sine) {
+    uint32_t index = _phase >> 24;
+    float fraction = (_phase & 0xffffff) * (1.0f / 0x1000000);
+    float current = _sineTable[index];
+    float next = _sineTable[(index + 1) & 0xff];
 
+    LFOValue = current + fraction * (next - current);
+
+  } else {                                   // Triangle, in phase with sine
+    int32_t t = (int32_t) (_phase + 0x40000000);
+    LFOValue = std::abs((int64_t) t) * (1.0f / 0x40000000) - 1;
   }
 
   // Apply fade
   if (_fade > 0) {
-    _currentValue = (double)(( _fadeMax - _fade) / (float) _fadeMax) * LFOValue;
-    _fade --;
+    _fade = std::max(_fade - (int) frames, 0);
+    LFOValue *= (float) (_fadeMax - _fade) / _fadeMax;
+  }
 
-  } else {
-    _currentValue = LFOValue;
+  return LFOValue;
+}
+
+
+// Calculate LFO values for a whole block of frames. Values are available
+// through value(frame) until next block is calculated.
+void WaveGenerator::next_block(uint32_t frames)
+{
+  for (uint32_t i = 0; i < frames; i++) {
+    next();
+    _block[i] = _currentValue;
   }
 }
 
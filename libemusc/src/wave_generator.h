@@ -21,6 +21,9 @@
 #define __WAVE_GENERATOR_H__
 
 
+#include "control_ramp.h"
+#include "settings.h"
+
 #include <array>
 
 #include <stdint.h>
@@ -37,36 +40,49 @@ public:
     triangle
   };
 
-  WaveGenerator(enum Waveform waveForm, uint32_t sampleRate, uint8_t baseFreq=0,
-		bool lut = true, bool interpolate = true);
+  WaveGenerator(enum Waveform waveForm, uint32_t sampleRate, uint8_t baseFreq=0);
   ~WaveGenerator();
 
   void set_delay(int delay);
   void set_fade(int fade);
+  void set_control_period(uint32_t frames);
+  void set_phase(float phase);     // Start phase, 0 - 1 = one period
 
   void update_frequency(int changeRate);
+  void set_frequency(float frequency);
 
   void next(void);
+  void next_block(uint32_t frames);
+
   inline double value() { return _currentValue; }
+  inline float value(uint32_t frame) { return _block[frame]; }
 
 private:
   WaveGenerator();
 
+  double _advance(uint32_t frames);
+
   enum Waveform _waveForm;
   uint32_t _sampleRate;
-  float _sampleFactor;
 
   uint8_t _baseFrequency;          // LFO base frequency for instrument (ROM)
+  int _rate;                       // Current LFO rate [0-127], 0.1 Hz steps
   float _frequency;                // LFO frequency in Hz
   int _delay;                      // Delay time in number of samples
   int _fade;                       // Fade time in number of samples
   int _fadeMax;
 
+  // Fixed point phase where 2^32 is one period. The upper 8 bits are used as
+  // index in the sine table and the lower 24 bits for interpolation.
+  uint32_t _phase;
+  uint32_t _phaseInc;              // Phase increment per frame
+  double _phaseScale;              // 2^32 / sample rate
+
   double _currentValue;
+  std::array<float, Settings::maxBlockSize> _block;  // Values for last block
 
-  bool _useLUT;
-  float _index;
-  bool _interpolate;               // Linear interpolation
+  uint32_t _controlPeriod;         // Frames between each LFO calculation
+  ControlRamp _ramp;
 
   // LFO delay times measured on an SC-55mkII
   static constexpr std::array<float, 128> _delayTable = {